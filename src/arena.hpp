@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace utilities {
+    // A monotonic arena which hands out memory from a list of large chunks.
+    // Deallocation is a no-op and all chunks are released when the arena is
+    // destroyed. This class is not thread safe.
+    class MonotonicArena {
+      public:
+        static constexpr size_t initial_chunk_size = 64 * 1024;
+        static constexpr size_t max_chunk_size = 16 * 1024 * 1024;
+
+        MonotonicArena() noexcept
+            : chunks(), current(nullptr), remain(0), next_chunk_size(initial_chunk_size),
+              reserved(0) {}
+        MonotonicArena(const MonotonicArena &) = delete;
+        MonotonicArena &operator=(const MonotonicArena &) = delete;
+        ~MonotonicArena() {
+            for (auto chunk : chunks) ::operator delete(chunk);
+        }
+
+        void *allocate(const size_t bytes, const size_t alignment) {
+            size_t padding = get_padding(alignment);
+            if (padding + bytes > remain) {
+                new_chunk(bytes + alignment);
+                padding = get_padding(alignment);
+            }
+            char *ptr = current + padding;
+            current = ptr + bytes;
+            remain -= padding + bytes;
+            return ptr;
+        }
+
+        // Return the number of bytes reserved from the system.
+        size_t size() const { return reserved; }
+
+      private:
+        std::vector<char *> chunks;
+        char *current;
+        size_t remain;
+        size_t next_chunk_size;
+        size_t reserved;
+
+        size_t get_padding(const size_t alignment) const {
+            return (alignment - reinterpret_cast<uintptr_t>(current) % alignment) % alignment;
+        }
+
+        void new_chunk(const size_t bytes) {
+            const size_t chunk_size = bytes > next_chunk_size ? bytes : next_chunk_size;
+            chunks.reserve(chunks.size() + 1);
+            current = static_cast<char *>(::operator new(chunk_size));
+            chunks.push_back(current);
+            remain = chunk_size;
+            reserved += chunk_size;
+            if (next_chunk_size < max_chunk_size) next_chunk_size *= 2;
+        }
+    };
+
+    // An allocator which allocates memory from a MonotonicArena. A default
+    // constructed allocator does not have an arena and falls back to the global
+    // operator new and delete. Copies of containers use the global heap so they
+    // can outlive the arena of the original container. Like std::pmr, the
+    // allocator never propagates on assignment or swap, so a container keeps
+    // its allocator and a move between different arenas copies the elements.
+    // A move constructed container still shares the arena of its source, so
+    // use the allocator-extended constructor when it has to outlive the source.
+    template <typename T> class ArenaAllocator {
+      public:
+        using value_type = T;
+        using propagate_on_container_copy_assignment = std::false_type;
+        using propagate_on_container_move_assignment = std::false_type;
+        using propagate_on_container_swap = std::false_type;
+
+        ArenaAllocator() noexcept : arena(nullptr) {}
+        explicit ArenaAllocator(MonotonicArena *an_arena) noexcept : arena(an_arena) {}
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U> &other) noexcept : arena(other.arena) {}
+
+        T *allocate(const size_t n) {
+            if (arena == nullptr) {
+                return static_cast<T *>(::operator new(n * sizeof(T)));
+            }
+            return static_cast<T *>(arena->allocate(n * sizeof(T), alignof(T)));
+        }
+
+        void deallocate(T *ptr, const size_t) noexcept {
+            if (arena == nullptr) {
+                ::operator delete(ptr);
+            }
+        }
+
+        ArenaAllocator select_on_container_copy_construction() const {
+            return ArenaAllocator();
+        }
+
+        MonotonicArena *arena;
+    };
+
+    template <typename T, typename U>
+    bool operator==(const ArenaAllocator<T> &first, const ArenaAllocator<U> &second) {
+        return first.arena == second.arena;
+    }
+
+    template <typename T, typename U>
+    bool operator!=(const ArenaAllocator<T> &first, const ArenaAllocator<U> &second) {
+        return first.arena != second.arena;
+    }
+} // namespace utilities
@@ -1,8 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <cassert>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "pugixml.hpp"
+
 #include "cereal/archives/binary.hpp"
 #include "cereal/archives/json.hpp"
 #include "cereal/archives/portable_binary.hpp"
@@ -12,11 +17,15 @@
 
 #include "fmt/format.h"
 
+#include "clover_scanner.hpp"
+#include "instrumentation.hpp"
+#include "utilities.hpp"
+#include "xml_scanner.hpp"
+
 // TODO: Save data into SQLite database.
 // TODO: We might need to sort the coverage data so we can reduce the access
 // time.
 // TODO: Write coverage data into database.
-// TODO: Create a report writer.
 // TODO: Figure out how to trade off between performance and storage? May be it
 // is not a big deal.
 // TODO: Allow users to get the code coverage for a given set of files and
@@ -125,10 +134,23 @@ namespace clover {
       public:
         using index_type = T1;
         using value_type = T2;
+        // The rows of INTERN are newly interned tests, files, and lines. The
+        // number of lookups is in the statistics of the maps.
+        enum Phases : size_t { LOAD = 0, DECODE = 1, INTERN = 2, APPEND = 3 };
+        enum Maps : size_t { FILE2IDX = 0, LINE2IDX = 1, TEST2IDX = 2 };
+
+        Database()
+            : recorder({"load", "decode", "intern", "append"},
+                       {"file2idx", "line2idx", "test2idx"}) {}
+
         bool parse(const index_type test_id, const char *xmlfile) {
             // Read the XML file
             pugi::xml_document doc;
-            pugi::xml_parse_result result = doc.load_file(xmlfile);
+            pugi::xml_parse_result result;
+            {
+                instrumentation::Recorder::Timer timer(recorder, LOAD);
+                result = doc.load_file(xmlfile);
+            }
             if (!result) {
                 return false; // Invalid XML file.
             }
@@ -142,6 +164,7 @@ namespace clover {
             // Only care about the line coverage information. We do not care
             // about project, package, and metrics because we can always
             // construct this information from line coverage data.
+            instrumentation::Recorder::Timer timer(recorder, DECODE);
             for (auto project_node = root_node.child("project"); project_node;
                  project_node = project_node.next_sibling("project")) {
                 for (auto package_node = project_node.child("package"); package_node;
@@ -156,8 +179,42 @@ namespace clover {
             return true;
         }
 
+        // Import coverage data using the schema specialized scanner instead of
+        // pugixml. Nothing is imported if an XML error is found.
+        bool scan(const index_type test_id, const char *xmlfile) {
+            std::string buffer;
+            try {
+                instrumentation::Recorder::Timer timer(recorder, LOAD);
+                buffer = utilities::read_file(xmlfile);
+            } catch (const std::runtime_error &) {
+                return false;
+            }
+            return scan(test_id, buffer.data(), buffer.data() + buffer.size());
+        }
+
+        // Import coverage data from a buffer which holds a clover XML file.
+        // Source files, lines, and coverage items are appended while the
+        // buffer is scanned, so they are rolled back if it is not valid.
+        bool scan(const index_type test_id, const char *begin, const char *end) {
+            instrumentation::Recorder::Timer timer(recorder, DECODE);
+            const size_t nfiles = source_files.size();
+            const size_t nlines = lines.size();
+            const size_t nitems = data.size();
+            ScanVisitor visitor(*this, test_id);
+            bool is_valid = false;
+            try {
+                is_valid = coverage::scan_clover(begin, end, visitor);
+            } catch (const std::runtime_error &) {
+                is_valid = false; // Invalid XML file.
+            }
+            if (!is_valid) rollback(nfiles, nlines, nitems);
+            return is_valid;
+        }
+
         // Return the index of a test point.
         index_type get_test_index(const Test val) {
+            instrumentation::Recorder::Timer timer(recorder, INTERN);
+            recorder.lookup(TEST2IDX, test2idx, val);
             auto it = test2idx.find(val);
             if (it != test2idx.end()) {
                 return it->second;
@@ -165,23 +222,46 @@ namespace clover {
 
             // Update tests and test2idx
             const auto pos = tests.size();
-            tests.push_back(val);
+            recorder.insert(TEST2IDX, test2idx);
+            recorder.add_rows(INTERN, 1);
+            recorder.push_back(tests, val);
             test2idx[val] = pos;
             return pos;
         }
 
         // Return the index of a source file.
         index_type get_file_index(std::string &&apath) {
+            instrumentation::Recorder::Timer timer(recorder, INTERN);
+            recorder.lookup(FILE2IDX, file2idx, apath);
             auto it = file2idx.find(apath);
             if (it == file2idx.end()) {
                 index_type pos = source_files.size();
+                recorder.insert(FILE2IDX, file2idx);
+                recorder.add_rows(INTERN, 1);
                 file2idx[apath] = pos;
-                source_files.emplace_back(apath);
+                recorder.push_back(source_files, apath);
                 return pos;
             }
             return it->second;
         }
 
+        // Return the collected statistics. This is empty if
+        // CLOVER_INSTRUMENTATION is not defined.
+        const instrumentation::Statistics &statistics() { return recorder.statistics(); }
+
+        // Return the number of coverage items.
+        size_t size() const { return data.size(); }
+
+        // Return the test table. A test id is an index into this table.
+        const std::vector<Test> &get_tests() const { return tests; }
+
+        // Return the source file and line tables and the coverage items.
+        const std::vector<std::string> &get_source_files() const { return source_files; }
+        const std::vector<Line<index_type>> &get_lines() const { return lines; }
+        const std::vector<LineCoverage<index_type, value_type>> &get_data() const {
+            return data;
+        }
+
         void info() {
             fmt::print("Number of source tests: {}\n", tests.size());
             fmt::print("Number of source files: {}\n", source_files.size());
@@ -213,6 +293,8 @@ namespace clover {
         }
 
       private:
+        instrumentation::Recorder recorder;
+
         // This hold a list of source files.
         std::vector<std::string> source_files;
 
@@ -231,6 +313,54 @@ namespace clover {
         // A map from a test object to the index in the test table.
         std::unordered_map<Test, index_type> test2idx;
 
+        // Import lines reported by coverage::scan_clover. The source file is
+        // interned when its first line is found.
+        struct ScanVisitor {
+            Database &db;
+            index_type test_id;
+            xml::Text path;
+            bool has_source_id;
+            index_type source_id;
+
+            ScanVisitor(Database &adb, const index_type id)
+                : db(adb), test_id(id), path(), has_source_id(false), source_id() {}
+
+            void begin_project(const xml::Text &, const xml::Text &) {}
+            void end_project() {}
+            void begin_package(const xml::Text &) {}
+            void end_package() {}
+            void begin_file(const xml::Text &apath, const xml::Text &) {
+                path = apath;
+                has_source_id = false;
+            }
+            void end_file() {}
+            void begin_class(const xml::Text &) {}
+            void end_class() {}
+            template <typename Metrics> void add_metrics(const Metrics &) {}
+            void add_line(const coverage::LineCoverage &line) {
+                if (!has_source_id) {
+                    std::string apath;
+                    xml::decode(path, apath);
+                    source_id = db.get_file_index(std::move(apath));
+                    has_source_id = true;
+                }
+                db.add_line(test_id, source_id, line);
+                db.recorder.add_rows(DECODE, 1);
+            }
+        };
+
+        // Remove the source files, lines, and coverage items which are added
+        // after the given sizes.
+        void rollback(const size_t nfiles, const size_t nlines, const size_t nitems) {
+            for (size_t idx = nfiles; idx < source_files.size(); ++idx) {
+                file2idx.erase(source_files[idx]);
+            }
+            for (size_t idx = nlines; idx < lines.size(); ++idx) line2idx.erase(lines[idx]);
+            source_files.erase(source_files.begin() + nfiles, source_files.end());
+            lines.erase(lines.begin() + nlines, lines.end());
+            data.erase(data.begin() + nitems, data.end());
+        }
+
         // Get a coverage type string.
         const char *get_type_string(const CoverageType type) {
             if (type == CoverageType::STMT) {
@@ -253,11 +383,14 @@ namespace clover {
             for (auto node = root_node.child("line"); node; node = node.next_sibling("line")) {
                 auto source_id = get_file_index(root_node.attribute("path").value());
                 parse_line_node(test_id, source_id, node);
+                recorder.add_rows(DECODE, 1);
             }
         }
 
         // Methods
         index_type get_line_idx(Line<index_type> &&aline) {
+            instrumentation::Recorder::Timer timer(recorder, INTERN);
+            recorder.lookup(LINE2IDX, line2idx, aline);
             auto it = line2idx.find(aline);
             if (it != line2idx.end()) {
                 return it->second;
@@ -265,13 +398,17 @@ namespace clover {
 
             // Push a given line into lines table and update the map.
             const index_type pos = lines.size();
+            recorder.insert(LINE2IDX, line2idx);
+            recorder.add_rows(INTERN, 1);
             line2idx[aline] = pos;
-            lines.push_back(aline);
+            recorder.push_back(lines, aline);
             return pos;
         }
 
         void add_coverage_info(LineCoverage<index_type, value_type> &&info) {
-            data.emplace_back(info); // TODO: How to avoid duplicated info?
+            instrumentation::Recorder::Timer timer(recorder, APPEND);
+            recorder.push_back(data, info); // TODO: How to avoid duplicated info?
+            recorder.add_rows(APPEND, 1);
         }
 
         void parse_line_node(const index_type test_id, const index_type source_id,
@@ -309,6 +446,34 @@ namespace clover {
             // Add coverage data.
             add_coverage_info({test_id, line_idx, info});
         }
+
+        // Same as parse_line_node for a line decoded by the scanner.
+        void add_line(const index_type test_id, const index_type source_id,
+                      const coverage::LineCoverage &line) {
+            const index_type line_idx = get_line_idx({source_id, line.num});
+            CoverageInfo<value_type> info;
+            if (line.type == coverage::CoverageType::STMT) {
+                info.type = CoverageType::STMT;
+                info.count = line.count;
+                if (!info.count) {
+                    return;
+                }
+            } else if (line.type == coverage::CoverageType::METHOD) {
+                info.type = CoverageType::METHOD;
+                info.count = line.count;
+                if (!info.count) {
+                    return;
+                }
+            } else {
+                info.type = CoverageType::COND;
+                info.truecount = line.truecount;
+                info.falsecount = line.falsecount;
+                if (!info.truecount || !info.falsecount) {
+                    return;
+                }
+            }
+            add_coverage_info({test_id, line_idx, info});
+        }
     };
 
 } // namespace clover
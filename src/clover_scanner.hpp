@@ -0,0 +1,318 @@
+#pragma once
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "clover_parser.hpp"
+#include "clover_schema.hpp"
+#include "data_structures.hpp"
+#include "instrumentation.hpp"
+#include "schema.hpp"
+#include "utilities.hpp"
+#include "xml_scanner.hpp"
+
+namespace coverage {
+    // XML parsers which can be used to read clover XML files.
+    enum class Backend : uint8_t { PUGIXML = 0, SCANNER = 1 };
+
+    namespace detail {
+        enum class Element : uint8_t {
+            NONE,
+            COVERAGE,
+            PROJECT,
+            PACKAGE,
+            FILE,
+            CLASS,
+            LINE,
+            METRICS,
+            OTHER
+        };
+
+        // Classify an element using its name and the type of its parent. We
+        // only care about coverage/project/package/file/{class,line} and the
+        // metrics of projects, packages, files, and classes.
+        inline Element classify(const xml::Text &name, const Element parent) {
+            switch (parent) {
+            case Element::NONE:
+                return name.equal("coverage", 8) ? Element::COVERAGE : Element::OTHER;
+            case Element::COVERAGE:
+                return name.equal("project", 7) ? Element::PROJECT : Element::OTHER;
+            case Element::PROJECT:
+                if (name.equal("metrics", 7)) return Element::METRICS;
+                return name.equal("package", 7) ? Element::PACKAGE : Element::OTHER;
+            case Element::PACKAGE:
+                if (name.equal("metrics", 7)) return Element::METRICS;
+                return name.equal("file", 4) ? Element::FILE : Element::OTHER;
+            case Element::FILE:
+                if (name.equal("line", 4)) return Element::LINE;
+                if (name.equal("metrics", 7)) return Element::METRICS;
+                return name.equal("class", 5) ? Element::CLASS : Element::OTHER;
+            case Element::CLASS:
+                return name.equal("metrics", 7) ? Element::METRICS : Element::OTHER;
+            default:
+                return Element::OTHER;
+            }
+        }
+
+        // Return the value of a given attribute or an empty text.
+        inline xml::Text find_attribute(const xml::Tag &tag, const char *name,
+                                        const size_t len) {
+            xml::AttributeReader reader(tag);
+            xml::Text key, value;
+            while (reader.next(key, value)) {
+                if (key.equal(name, len)) return value;
+            }
+            return xml::Text();
+        }
+
+        // Decode an element using its schema.
+        template <typename T> T parse(const xml::Tag &tag) {
+            T item = T();
+            schema::Parser<T>::parse(tag, item);
+            return item;
+        }
+
+        // Decode a metrics element using the schema of its parent.
+        template <typename Visitor>
+        void parse_metrics(const xml::Tag &tag, const Element parent, Visitor &visitor) {
+            switch (parent) {
+            case Element::PROJECT:
+                visitor.add_metrics(parse<ProjectMetrics>(tag));
+                break;
+            case Element::PACKAGE:
+                visitor.add_metrics(parse<PackageMetrics>(tag));
+                break;
+            case Element::FILE:
+                visitor.add_metrics(parse<FileMetrics>(tag));
+                break;
+            case Element::CLASS:
+                visitor.add_metrics(parse<ClassMetrics>(tag));
+                break;
+            default:
+                break;
+            }
+        }
+    } // namespace detail
+
+    // Scan a clover XML buffer and report its elements to a visitor which has
+    // below methods
+    //   begin_project(timestamp, name), end_project()
+    //   begin_package(name), end_package()
+    //   begin_file(path, name), end_file()
+    //   begin_class(name), end_class()
+    //   add_line(const LineCoverage &)
+    //   add_metrics(const {Project,Package,File,Class}Metrics &)
+    // String values are passed as raw xml::Text and should be decoded using
+    // xml::decode. Return false if the buffer is not a clover XML document and
+    // throw std::runtime_error if it is not a valid XML document.
+    template <typename Visitor>
+    bool scan_clover(const char *begin, const char *end, Visitor &visitor) {
+        using detail::Element;
+        std::vector<Element> stack(1, Element::NONE);
+        std::vector<xml::Text> names(1); // The names of the open elements.
+        xml::Tokenizer tokenizer(begin, end);
+        xml::Tag tag;
+        bool has_root = false;
+        while (tokenizer.next(tag)) {
+            if (tag.kind == xml::Tag::END) {
+                if (stack.size() < 2) throw std::runtime_error("Unexpected end tag");
+                if (!tag.name.equal(names.back().begin, names.back().size())) {
+                    throw std::runtime_error("Mismatched end tag");
+                }
+                const Element kind = stack.back();
+                stack.pop_back();
+                names.pop_back();
+                if (kind == Element::PROJECT) visitor.end_project();
+                if (kind == Element::PACKAGE) visitor.end_package();
+                if (kind == Element::FILE) visitor.end_file();
+                if (kind == Element::CLASS) visitor.end_class();
+                continue;
+            }
+
+            const Element kind = detail::classify(tag.name, stack.back());
+            switch (kind) {
+            case Element::COVERAGE:
+                if (detail::find_attribute(tag, "clover", 6).begin == nullptr) {
+                    return false;
+                }
+                break;
+            case Element::PROJECT:
+                visitor.begin_project(detail::find_attribute(tag, "timestamp", 9),
+                                      detail::find_attribute(tag, "name", 4));
+                break;
+            case Element::PACKAGE:
+                visitor.begin_package(detail::find_attribute(tag, "name", 4));
+                break;
+            case Element::FILE:
+                visitor.begin_file(detail::find_attribute(tag, "path", 4),
+                                   detail::find_attribute(tag, "name", 4));
+                break;
+            case Element::CLASS:
+                visitor.begin_class(detail::find_attribute(tag, "name", 4));
+                break;
+            case Element::LINE:
+                visitor.add_line(detail::parse<LineCoverage>(tag));
+                break;
+            case Element::METRICS:
+                detail::parse_metrics(tag, stack.back(), visitor);
+                break;
+            default:
+                if (stack.size() == 1) return false; // The root is not a coverage element.
+                break;
+            }
+
+            if (stack.size() == 1) {
+                if (has_root) throw std::runtime_error("Multiple root elements");
+                has_root = true;
+            }
+
+            if (tag.kind == xml::Tag::START) {
+                stack.push_back(kind);
+                names.push_back(tag.name);
+            } else {
+                if (kind == Element::PROJECT) visitor.end_project();
+                if (kind == Element::PACKAGE) visitor.end_package();
+                if (kind == Element::FILE) visitor.end_file();
+                if (kind == Element::CLASS) visitor.end_class();
+            }
+        }
+
+        if (stack.size() != 1) throw std::runtime_error("Unterminated element");
+        return has_root;
+    }
+
+    // A schema specialized alternative of CloverParser. It produces the same
+    // ProjectCoverage without building a DOM.
+    class CloverScanner {
+      public:
+        enum Phases : size_t { LOAD = 0, DECODE = 1 };
+
+        CloverScanner() : recorder({"load", "decode"}) {}
+
+        ProjectCoverage operator()(const std::string &data_file) {
+            std::string buffer;
+            {
+                instrumentation::Recorder::Timer timer(recorder, LOAD);
+                buffer = utilities::read_file(data_file);
+            }
+            return (*this)(buffer.data(), buffer.data() + buffer.size(), data_file);
+        }
+
+        ProjectCoverage operator()(const char *begin, const char *end,
+                                   const std::string &data_file) {
+            instrumentation::Recorder::Timer timer(recorder, DECODE);
+            ProjectCoverage results;
+            TreeBuilder builder(results);
+            bool is_clover;
+            try {
+                is_clover = scan_clover(begin, end, builder);
+            } catch (const std::runtime_error &) {
+                throw std::runtime_error("Invalid xml file: " + data_file);
+            }
+            if (!is_clover) {
+                throw std::runtime_error("Invalid clover code coverage xml file!");
+            }
+            recorder.add_rows(DECODE, builder.rows);
+            recorder.allocate(results.arena->size());
+            return results;
+        }
+
+        // Return the collected statistics. This is empty if
+        // CLOVER_INSTRUMENTATION is not defined.
+        const instrumentation::Statistics &statistics() { return recorder.statistics(); }
+
+      private:
+        instrumentation::Recorder recorder;
+
+        // Build a ProjectCoverage tree. Like CloverParser only the first
+        // project is used.
+        struct TreeBuilder {
+            ProjectCoverage &results;
+            int projects;
+            bool in_project;
+            bool in_package;
+            bool in_file;
+            bool in_class;
+            size_t rows;
+
+            explicit TreeBuilder(ProjectCoverage &data)
+                : results(data), projects(0), in_project(false), in_package(false),
+                  in_file(false), in_class(false), rows(0) {}
+
+            void begin_project(const xml::Text &timestamp, const xml::Text &name) {
+                in_project = (++projects == 1);
+                if (!in_project) return;
+                xml::decode(timestamp, results.timestamp);
+                xml::decode(name, results.name);
+            }
+
+            void end_project() { in_project = false; }
+
+            void begin_package(const xml::Text &name) {
+                in_package = in_project;
+                if (!in_package) return;
+                results.packages.emplace_back();
+                xml::decode(name, results.packages.back().name);
+            }
+
+            void end_package() { in_package = false; }
+
+            void begin_file(const xml::Text &path, const xml::Text &name) {
+                in_file = in_package;
+                if (!in_file) return;
+                auto &files = results.packages.back().files;
+                files.emplace_back();
+                xml::decode(path, files.back().path);
+                xml::decode(name, files.back().name);
+            }
+
+            void end_file() { in_file = false; }
+
+            void begin_class(const xml::Text &name) {
+                in_class = in_file;
+                if (!in_class) return;
+                auto &classes = results.packages.back().files.back().classes;
+                classes.emplace_back();
+                xml::decode(name, classes.back().name);
+            }
+
+            void end_class() { in_class = false; }
+
+            void add_line(const LineCoverage &line) {
+                if (!in_file) return;
+                results.packages.back().files.back().lines.push_back(line);
+                ++rows;
+            }
+
+            void add_metrics(const ProjectMetrics &metrics) {
+                if (in_project) results.metrics = metrics;
+            }
+
+            void add_metrics(const PackageMetrics &metrics) {
+                if (in_package) results.packages.back().metrics = metrics;
+            }
+
+            void add_metrics(const FileMetrics &metrics) {
+                if (in_file) results.packages.back().files.back().metrics = metrics;
+            }
+
+            void add_metrics(const ClassMetrics &metrics) {
+                if (!in_class) return;
+                results.packages.back().files.back().classes.back().metrics = metrics;
+            }
+        };
+    };
+
+    // Read a clover XML file using a given backend.
+    ProjectCoverage read_clover(const std::string &data_file,
+                                const Backend backend = Backend::PUGIXML) {
+        if (backend == Backend::SCANNER) {
+            CloverScanner scanner;
+            return scanner(data_file);
+        }
+        CloverParser parser;
+        return parser(data_file);
+    }
+} // namespace coverage
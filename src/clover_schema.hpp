@@ -0,0 +1,129 @@
+#pragma once
+
+#include <tuple>
+
+#include "data_structures.hpp"
+#include "schema.hpp"
+#include "xml_scanner.hpp"
+
+namespace coverage {
+    // Line types which are not known are ignored.
+    inline void decode(const xml::Text &text, CoverageType &value) {
+        if (text.equal("stmt", 4)) {
+            value = CoverageType::STMT;
+        } else if (text.equal("method", 6)) {
+            value = CoverageType::METHOD;
+        } else if (text.equal("cond", 4)) {
+            value = CoverageType::COND;
+        }
+    }
+} // namespace coverage
+
+// The XML schema of clover coverage reports. Metrics of an element are stored
+// in a metrics child element and metrics of outer elements extend the metrics
+// of inner elements, e.g. the metrics of a project are
+//   <metrics packages="1" files="2" classes="3" elements="4" ... />
+namespace schema {
+    template <> struct Schema<coverage::ClassMetrics> : Leaf {
+        static constexpr auto attributes() {
+            using coverage::ClassMetrics;
+            return std::make_tuple(
+                attribute("elements", &ClassMetrics::elements),
+                attribute("coveredelements", &ClassMetrics::coveredelements),
+                attribute("statements", &ClassMetrics::statements),
+                attribute("coveredstatements", &ClassMetrics::coveredstatements),
+                attribute("conditionals", &ClassMetrics::conditionals),
+                attribute("coveredconditionals", &ClassMetrics::coveredconditionals),
+                attribute("methods", &ClassMetrics::methods),
+                attribute("coveredmethods", &ClassMetrics::coveredmethods),
+                attribute("complexity", &ClassMetrics::complexity),
+                attribute("loc", &ClassMetrics::loc), attribute("ncloc", &ClassMetrics::ncloc));
+        }
+    };
+
+    template <> struct Schema<coverage::FileMetrics> : Leaf {
+        static constexpr auto attributes() {
+            using coverage::FileMetrics;
+            return std::tuple_cat(
+                std::make_tuple(attribute("classes", &FileMetrics::classes)),
+                nested(&FileMetrics::metrics, Schema<coverage::ClassMetrics>::attributes()));
+        }
+    };
+
+    template <> struct Schema<coverage::PackageMetrics> : Leaf {
+        static constexpr auto attributes() {
+            using coverage::PackageMetrics;
+            return std::tuple_cat(
+                std::make_tuple(attribute("files", &PackageMetrics::files)),
+                nested(&PackageMetrics::metrics, Schema<coverage::FileMetrics>::attributes()));
+        }
+    };
+
+    template <> struct Schema<coverage::ProjectMetrics> : Leaf {
+        static constexpr auto attributes() {
+            using coverage::ProjectMetrics;
+            return std::tuple_cat(
+                std::make_tuple(attribute("packages", &ProjectMetrics::packages)),
+                nested(&ProjectMetrics::metrics,
+                       Schema<coverage::PackageMetrics>::attributes()));
+        }
+    };
+
+    template <> struct Schema<coverage::LineCoverage> : Leaf {
+        static constexpr auto attributes() {
+            using coverage::LineCoverage;
+            return std::make_tuple(attribute("num", &LineCoverage::num),
+                                   attribute("count", &LineCoverage::count),
+                                   attribute("type", &LineCoverage::type),
+                                   attribute("truecount", &LineCoverage::truecount),
+                                   attribute("falsecount", &LineCoverage::falsecount));
+        }
+    };
+
+    template <> struct Schema<coverage::ClassCoverage> : Leaf {
+        static constexpr auto attributes() {
+            return std::make_tuple(attribute("name", &coverage::ClassCoverage::name));
+        }
+        static constexpr auto children() {
+            return std::make_tuple(child("metrics", &coverage::ClassCoverage::metrics));
+        }
+    };
+
+    template <> struct Schema<coverage::FileCoverage> : Leaf {
+        static constexpr auto attributes() {
+            using coverage::FileCoverage;
+            return std::make_tuple(attribute("path", &FileCoverage::path),
+                                   attribute("name", &FileCoverage::name));
+        }
+        static constexpr auto children() {
+            using coverage::FileCoverage;
+            return std::make_tuple(child("metrics", &FileCoverage::metrics),
+                                   child("class", &FileCoverage::classes),
+                                   child("line", &FileCoverage::lines));
+        }
+    };
+
+    template <> struct Schema<coverage::PackageCoverage> : Leaf {
+        static constexpr auto attributes() {
+            return std::make_tuple(attribute("name", &coverage::PackageCoverage::name));
+        }
+        static constexpr auto children() {
+            using coverage::PackageCoverage;
+            return std::make_tuple(child("metrics", &PackageCoverage::metrics),
+                                   child("file", &PackageCoverage::files));
+        }
+    };
+
+    template <> struct Schema<coverage::ProjectCoverage> : Leaf {
+        static constexpr auto attributes() {
+            using coverage::ProjectCoverage;
+            return std::make_tuple(attribute("timestamp", &ProjectCoverage::timestamp),
+                                   attribute("name", &ProjectCoverage::name));
+        }
+        static constexpr auto children() {
+            using coverage::ProjectCoverage;
+            return std::make_tuple(child("metrics", &ProjectCoverage::metrics),
+                                   child("package", &ProjectCoverage::packages));
+        }
+    };
+} // namespace schema
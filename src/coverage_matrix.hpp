@@ -0,0 +1,196 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace clover {
+    // Bitsets over test ids which are used to select a set of tests.
+    using word_type = uint64_t;
+    constexpr size_t bits_per_word = 64;
+
+    inline size_t number_of_words(const size_t bits) {
+        return (bits + bits_per_word - 1) / bits_per_word;
+    }
+
+    inline void set_bit(std::vector<word_type> &bits, const size_t idx) {
+        bits[idx / bits_per_word] |= word_type(1) << (idx % bits_per_word);
+    }
+
+    inline bool test_bit(const word_type *bits, const size_t idx) {
+        return (bits[idx / bits_per_word] >> (idx % bits_per_word)) & 1;
+    }
+
+    // Return the number of set bits of a bitset. This is a scalar loop which
+    // compiles to one popcnt instruction per word on targets which have it.
+    inline size_t popcount(const word_type *bits, const size_t nwords) {
+        size_t count = 0;
+        for (size_t idx = 0; idx < nwords; ++idx) count += __builtin_popcountll(bits[idx]);
+        return count;
+    }
+
+    // A boolean test by line coverage matrix. Rows of tests are sorted lists
+    // of line ids. Columns of lines which are covered by few tests are sorted
+    // lists of test ids, and columns of lines which are covered by many tests,
+    // e.g. setup code, are bitsets over tests. A bitset column is used when it
+    // is not larger than a list, so counting the tests of a set which cover a
+    // line is a popcount loop or a short list of bit lookups.
+    class CoverageMatrix {
+      public:
+        using id_type = uint32_t;
+        static constexpr id_type npos = std::numeric_limits<id_type>::max();
+
+        struct Entry {
+            id_type test_id;
+            id_type line_id;
+        };
+
+        // A view of a sorted list of ids.
+        struct Row {
+            const id_type *first;
+            const id_type *last;
+            const id_type *begin() const { return first; }
+            const id_type *end() const { return last; }
+            size_t size() const { return last - first; }
+        };
+
+        CoverageMatrix() : ntests(0), nlines(0), nwords(0) {}
+
+        // Build a matrix from a list of covered (test, line) pairs. Duplicated
+        // pairs are ignored.
+        CoverageMatrix(const size_t tests, const size_t lines, std::vector<Entry> entries)
+            : ntests(tests), nlines(lines), nwords(number_of_words(tests)) {
+            build_rows(entries);
+            std::vector<Entry>().swap(entries);
+            build_columns();
+        }
+
+        size_t number_of_tests() const { return ntests; }
+        size_t number_of_lines() const { return nlines; }
+
+        // Return the number of covered (test, line) pairs.
+        size_t size() const { return test_lines.size(); }
+
+        // Return the number of words of a bitset over tests.
+        size_t words_per_bitset() const { return nwords; }
+
+        // Return the sorted list of lines which are covered by a test.
+        Row lines_of(const size_t test_id) const {
+            const id_type *data = test_lines.data();
+            return {data + test_offsets[test_id], data + test_offsets[test_id + 1]};
+        }
+
+        // Return the number of tests which cover a line.
+        size_t degree(const size_t line_id) const { return line_degrees[line_id]; }
+
+        // Return the number of tests in a given bitset which cover a line.
+        size_t count(const size_t line_id, const word_type *tests) const {
+            const id_type column = dense_columns[line_id];
+            if (column != npos) {
+                const word_type *bits = dense_bits.data() + column * nwords;
+                size_t result = 0;
+                for (size_t idx = 0; idx < nwords; ++idx) {
+                    result += __builtin_popcountll(bits[idx] & tests[idx]);
+                }
+                return result;
+            }
+
+            size_t result = 0;
+            const id_type *last = line_tests.data() + line_offsets[line_id + 1];
+            for (auto ptr = line_tests.data() + line_offsets[line_id]; ptr != last; ++ptr) {
+                result += test_bit(tests, *ptr);
+            }
+            return result;
+        }
+
+      private:
+        size_t ntests;
+        size_t nlines;
+        size_t nwords;
+
+        std::vector<size_t> test_offsets;
+        std::vector<id_type> test_lines;
+
+        std::vector<id_type> line_degrees;
+        std::vector<id_type> dense_columns; // An index into dense_bits or npos.
+        std::vector<size_t> line_offsets;   // Offsets of sparse columns.
+        std::vector<id_type> line_tests;
+        std::vector<word_type> dense_bits;
+
+        // Bucket entries by test then sort and deduplicate each row.
+        void build_rows(const std::vector<Entry> &entries) {
+            test_offsets.assign(ntests + 1, 0);
+            for (const Entry &item : entries) ++test_offsets[item.test_id + 1];
+            for (size_t idx = 0; idx < ntests; ++idx) {
+                test_offsets[idx + 1] += test_offsets[idx];
+            }
+
+            test_lines.resize(entries.size());
+            std::vector<size_t> cursor(test_offsets.begin(), test_offsets.end() - 1);
+            for (const Entry &item : entries) test_lines[cursor[item.test_id]++] = item.line_id;
+
+            size_t pos = 0;
+            for (size_t idx = 0; idx < ntests; ++idx) {
+                auto first = test_lines.begin() + test_offsets[idx];
+                auto last = test_lines.begin() + test_offsets[idx + 1];
+                std::sort(first, last);
+                last = std::unique(first, last);
+                test_offsets[idx] = pos;
+                pos = std::copy(first, last, test_lines.begin() + pos) - test_lines.begin();
+            }
+            test_offsets[ntests] = pos;
+            test_lines.resize(pos);
+            test_lines.shrink_to_fit();
+        }
+
+        // Transpose rows into columns. Rows are visited in test order so all
+        // columns are sorted.
+        void build_columns() {
+            line_degrees.assign(nlines, 0);
+            for (const id_type line_id : test_lines) ++line_degrees[line_id];
+
+            dense_columns.assign(nlines, static_cast<id_type>(npos));
+            line_offsets.assign(nlines + 1, 0);
+            id_type ndense = 0;
+            for (size_t idx = 0; idx < nlines; ++idx) {
+                const size_t degree = line_degrees[idx];
+                const bool is_dense = degree * sizeof(id_type) >= nwords * sizeof(word_type);
+                if (is_dense) dense_columns[idx] = ndense++;
+                line_offsets[idx + 1] = line_offsets[idx] + (is_dense ? 0 : degree);
+            }
+
+            line_tests.resize(line_offsets[nlines]);
+            dense_bits.assign(static_cast<size_t>(ndense) * nwords, 0);
+            std::vector<size_t> cursor(line_offsets.begin(), line_offsets.end() - 1);
+            for (size_t test_id = 0; test_id < ntests; ++test_id) {
+                for (const id_type line_id : lines_of(test_id)) {
+                    const id_type column = dense_columns[line_id];
+                    if (column != npos) {
+                        dense_bits[column * nwords + test_id / bits_per_word] |=
+                            word_type(1) << (test_id % bits_per_word);
+                    } else {
+                        line_tests[cursor[line_id]++] = static_cast<id_type>(test_id);
+                    }
+                }
+            }
+        }
+    };
+
+    // Build a coverage matrix from the coverage items of a Database. Test ids
+    // which are not in the test table, e.g. ids passed to Database::parse,
+    // are included.
+    template <typename Database> CoverageMatrix make_coverage_matrix(const Database &db) {
+        const auto &data = db.get_data();
+        std::vector<CoverageMatrix::Entry> entries;
+        entries.reserve(data.size());
+        size_t ntests = db.get_tests().size();
+        for (const auto &item : data) {
+            entries.push_back({static_cast<CoverageMatrix::id_type>(item.test_id),
+                               static_cast<CoverageMatrix::id_type>(item.line_id)});
+            ntests = std::max<size_t>(ntests, item.test_id + 1);
+        }
+        return CoverageMatrix(ntests, db.get_lines().size(), std::move(entries));
+    }
+} // namespace clover
@@ -1,6 +1,11 @@
 #pragma once
 
+#include <memory>
+#include <new>
+#include <scoped_allocator>
 #include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 
 #include "cereal/archives/binary.hpp"
@@ -10,11 +15,21 @@
 #include "cereal/types/string.hpp"
 #include "cereal/types/vector.hpp"
 
+#include "arena.hpp"
+
 namespace coverage {
     enum class CoverageType { STMT, METHOD, COND };
 
     using index_type = size_t;
 
+    // Strings and vectors of a coverage tree use the arena of the tree. Nested
+    // elements of a vector get the allocator of the vector.
+    using allocator_type = utilities::ArenaAllocator<char>;
+    using string_type = std::basic_string<char, std::char_traits<char>, allocator_type>;
+    template <typename T>
+    using vector_type =
+        std::vector<T, std::scoped_allocator_adaptor<utilities::ArenaAllocator<T>>>;
+
     struct Line {
         index_type source_id;
         unsigned int num;
@@ -118,48 +133,232 @@ namespace coverage {
         }
     };
 
+    // cereal's JSON archives only support std::string so arena strings are
+    // serialized through a temporary std::string.
+    template <typename Archive>
+    void save_string(Archive &ar, const char *name, const string_type &value) {
+        ar(cereal::make_nvp(name, std::string(value.data(), value.size())));
+    }
+
+    template <typename Archive>
+    void load_string(Archive &ar, const char *name, string_type &value) {
+        std::string buffer;
+        ar(cereal::make_nvp(name, buffer));
+        value.assign(buffer.data(), buffer.size());
+    }
+
     struct ClassCoverage {
-        std::string name;
-        ClassCoverage() noexcept = default;
-        template <typename Archive> void serialize(Archive &ar) {
-            ar(cereal::make_nvp("name", name));
+        using allocator_type = coverage::allocator_type;
+        string_type name;
+        ClassMetrics metrics;
+
+        ClassCoverage() noexcept : name(), metrics() {}
+        ClassCoverage(const ClassCoverage &) = default;
+        ClassCoverage(ClassCoverage &&) = default;
+        explicit ClassCoverage(const allocator_type &alloc) : name(alloc), metrics() {}
+        ClassCoverage(const ClassCoverage &other, const allocator_type &alloc)
+            : name(other.name, alloc), metrics(other.metrics) {}
+        ClassCoverage(ClassCoverage &&other, const allocator_type &alloc)
+            : name(std::move(other.name), alloc), metrics(other.metrics) {}
+        ClassCoverage &operator=(const ClassCoverage &) = default;
+        ClassCoverage &operator=(ClassCoverage &&) = default;
+
+        template <typename Archive> void save(Archive &ar) const {
+            save_string(ar, "name", name);
+            ar(cereal::make_nvp("metrics", metrics));
+        }
+        template <typename Archive> void load(Archive &ar) {
+            load_string(ar, "name", name);
+            ar(cereal::make_nvp("metrics", metrics));
         }
     };
 
     struct FileCoverage {
-        std::string path;
-        std::string name;
-        std::vector<ClassCoverage> classes;
-        std::vector<LineCoverage> lines;
+        using allocator_type = coverage::allocator_type;
+        string_type path;
+        string_type name;
+        vector_type<ClassCoverage> classes;
+        vector_type<LineCoverage> lines;
+        FileMetrics metrics;
 
         FileCoverage() noexcept = default;
+        FileCoverage(const FileCoverage &) = default;
+        FileCoverage(FileCoverage &&) = default;
+        explicit FileCoverage(const allocator_type &alloc)
+            : path(alloc), name(alloc), classes(alloc), lines(alloc), metrics() {}
+        FileCoverage(const FileCoverage &other, const allocator_type &alloc)
+            : path(other.path, alloc), name(other.name, alloc), classes(other.classes, alloc),
+              lines(other.lines, alloc), metrics(other.metrics) {}
+        FileCoverage(FileCoverage &&other, const allocator_type &alloc)
+            : path(std::move(other.path), alloc), name(std::move(other.name), alloc),
+              classes(std::move(other.classes), alloc), lines(std::move(other.lines), alloc),
+              metrics(other.metrics) {}
+        FileCoverage &operator=(const FileCoverage &) = default;
+        FileCoverage &operator=(FileCoverage &&) = default;
 
-        template <typename Archive> void serialize(Archive &ar) {
-            ar(cereal::make_nvp("path", path), cereal::make_nvp("name", name),
-               cereal::make_nvp("classes", classes), cereal::make_nvp("lines", lines));
+        template <typename Archive> void save(Archive &ar) const {
+            save_string(ar, "path", path);
+            save_string(ar, "name", name);
+            ar(cereal::make_nvp("classes", classes), cereal::make_nvp("lines", lines),
+               cereal::make_nvp("metrics", metrics));
+        }
+        template <typename Archive> void load(Archive &ar) {
+            load_string(ar, "path", path);
+            load_string(ar, "name", name);
+            ar(cereal::make_nvp("classes", classes), cereal::make_nvp("lines", lines),
+               cereal::make_nvp("metrics", metrics));
         }
     };
 
     struct PackageCoverage {
-        std::string name;
-        std::vector<FileCoverage> files;
+        using allocator_type = coverage::allocator_type;
+        string_type name;
+        vector_type<FileCoverage> files;
+        PackageMetrics metrics;
 
         PackageCoverage() noexcept = default;
-        template <typename Archive> void serialize(Archive &ar) {
-            ar(cereal::make_nvp("name", name), cereal::make_nvp("files", files));
+        PackageCoverage(const PackageCoverage &) = default;
+        PackageCoverage(PackageCoverage &&) = default;
+        explicit PackageCoverage(const allocator_type &alloc)
+            : name(alloc), files(alloc), metrics() {}
+        PackageCoverage(const PackageCoverage &other, const allocator_type &alloc)
+            : name(other.name, alloc), files(other.files, alloc), metrics(other.metrics) {}
+        PackageCoverage(PackageCoverage &&other, const allocator_type &alloc)
+            : name(std::move(other.name), alloc), files(std::move(other.files), alloc),
+              metrics(other.metrics) {}
+        PackageCoverage &operator=(const PackageCoverage &) = default;
+        PackageCoverage &operator=(PackageCoverage &&) = default;
+
+        template <typename Archive> void save(Archive &ar) const {
+            save_string(ar, "name", name);
+            ar(cereal::make_nvp("files", files), cereal::make_nvp("metrics", metrics));
+        }
+        template <typename Archive> void load(Archive &ar) {
+            load_string(ar, "name", name);
+            ar(cereal::make_nvp("files", files), cereal::make_nvp("metrics", metrics));
         }
     };
 
+    // The root of a coverage tree. All strings and vectors of the tree are
+    // allocated from the arena owned by this object, so the whole tree lives
+    // in a few large chunks and is released at once. A copy gets its own arena.
+    // Copy or move assigning an element of the tree to an element which has
+    // another allocator copies its data, but a move constructed element shares
+    // the arena of the tree. Elements which outlive the tree must be created
+    // with the allocator-extended constructors, e.g.
+    //   FileCoverage file(std::move(project.packages[0].files[0]), allocator_type());
     struct ProjectCoverage {
-        std::string timestamp;
-        std::string name;
-        std::vector<PackageCoverage> packages;
-        ProjectCoverage() noexcept = default;
-        template <typename Archive> void serialize(Archive &ar) {
-            ar(cereal::make_nvp("timestamp", timestamp), cereal::make_nvp("name", name),
-               cereal::make_nvp("packages", packages));
+        using allocator_type = coverage::allocator_type;
+
+        // The arena must be declared first so it is destroyed last.
+        std::shared_ptr<utilities::MonotonicArena> arena;
+        string_type timestamp;
+        string_type name;
+        vector_type<PackageCoverage> packages;
+        ProjectMetrics metrics;
+
+        ProjectCoverage() : ProjectCoverage(std::make_shared<utilities::MonotonicArena>()) {}
+        explicit ProjectCoverage(std::shared_ptr<utilities::MonotonicArena> an_arena)
+            : arena(std::move(an_arena)), timestamp(get_allocator()), name(get_allocator()),
+              packages(get_allocator()), metrics() {}
+        ProjectCoverage(const ProjectCoverage &other) : ProjectCoverage() { *this = other; }
+        ProjectCoverage(ProjectCoverage &&) = default;
+
+        // Copy data into the arena of this object.
+        ProjectCoverage &operator=(const ProjectCoverage &other) {
+            timestamp = other.timestamp;
+            name = other.name;
+            packages = other.packages;
+            metrics = other.metrics;
+            return *this;
+        }
+
+        // Take over the arena of other. Assigning the members would copy them
+        // into our old arena because allocators do not propagate, so they are
+        // move constructed in place, which takes the allocator of other. Our
+        // old data has to be destroyed before our old arena.
+        ProjectCoverage &operator=(ProjectCoverage &&other) noexcept {
+            if (this == &other) return *this;
+            replace(timestamp, std::move(other.timestamp));
+            replace(name, std::move(other.name));
+            replace(packages, std::move(other.packages));
+            metrics = other.metrics;
+            arena = std::move(other.arena);
+            return *this;
+        }
+
+        allocator_type get_allocator() const { return allocator_type(arena.get()); }
+
+        template <typename Archive> void save(Archive &ar) const {
+            save_string(ar, "timestamp", timestamp);
+            save_string(ar, "name", name);
+            ar(cereal::make_nvp("packages", packages), cereal::make_nvp("metrics", metrics));
+        }
+        template <typename Archive> void load(Archive &ar) {
+            load_string(ar, "timestamp", timestamp);
+            load_string(ar, "name", name);
+            ar(cereal::make_nvp("packages", packages), cereal::make_nvp("metrics", metrics));
+        }
+
+      private:
+        // Destroy a member and move construct it from value.
+        template <typename T> static void replace(T &member, T &&value) noexcept {
+            member.~T();
+            new (&member) T(std::move(value));
         }
     };
+
+    // Operators which are used to cross validate parser backends.
+    bool operator==(const ClassMetrics &first, const ClassMetrics &second) {
+        return std::tie(first.elements, first.coveredelements, first.statements,
+                        first.coveredstatements, first.conditionals, first.coveredconditionals,
+                        first.methods, first.coveredmethods, first.complexity, first.loc,
+                        first.ncloc) ==
+               std::tie(second.elements, second.coveredelements, second.statements,
+                        second.coveredstatements, second.conditionals,
+                        second.coveredconditionals, second.methods, second.coveredmethods,
+                        second.complexity, second.loc, second.ncloc);
+    }
+
+    bool operator==(const FileMetrics &first, const FileMetrics &second) {
+        return std::tie(first.classes, first.metrics) ==
+               std::tie(second.classes, second.metrics);
+    }
+
+    bool operator==(const PackageMetrics &first, const PackageMetrics &second) {
+        return std::tie(first.files, first.metrics) == std::tie(second.files, second.metrics);
+    }
+
+    bool operator==(const ProjectMetrics &first, const ProjectMetrics &second) {
+        return std::tie(first.packages, first.metrics) ==
+               std::tie(second.packages, second.metrics);
+    }
+
+    bool operator==(const LineCoverage &first, const LineCoverage &second) {
+        return std::tie(first.num, first.count, first.type, first.truecount,
+                        first.falsecount) == std::tie(second.num, second.count, second.type,
+                                                      second.truecount, second.falsecount);
+    }
+
+    bool operator==(const ClassCoverage &first, const ClassCoverage &second) {
+        return std::tie(first.name, first.metrics) == std::tie(second.name, second.metrics);
+    }
+
+    bool operator==(const FileCoverage &first, const FileCoverage &second) {
+        return std::tie(first.path, first.name, first.classes, first.lines, first.metrics) ==
+               std::tie(second.path, second.name, second.classes, second.lines,
+                        second.metrics);
+    }
+
+    bool operator==(const PackageCoverage &first, const PackageCoverage &second) {
+        return std::tie(first.name, first.files, first.metrics) ==
+               std::tie(second.name, second.files, second.metrics);
+    }
+
+    bool operator==(const ProjectCoverage &first, const ProjectCoverage &second) {
+        return std::tie(first.timestamp, first.name, first.packages, first.metrics) ==
+               std::tie(second.timestamp, second.name, second.packages, second.metrics);
+    }
 } // namespace coverage
 
 namespace std {}
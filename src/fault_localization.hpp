@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <queue>
+#include <vector>
+
+#include "coverage_matrix.hpp"
+#include "test_outcomes.hpp"
+
+// Spectrum based fault localization. A line is suspicious if it is covered by
+// many failed tests and few passed tests. Tests whose outcome is UNKNOWN or
+// SKIPPED are not a part of the spectrum.
+namespace sbfl {
+    enum class Formula : uint8_t { OCHIAI = 0, TARANTULA = 1, DSTAR = 2 };
+
+    struct Spectrum {
+        size_t failed;       // Failed tests which cover a line.
+        size_t passed;       // Passed tests which cover a line.
+        size_t total_failed; // All failed tests.
+        size_t total_passed; // All passed tests.
+    };
+
+    inline double ochiai(const Spectrum &s) {
+        const double denominator = std::sqrt(static_cast<double>(s.total_failed) *
+                                             static_cast<double>(s.failed + s.passed));
+        return denominator > 0 ? s.failed / denominator : 0;
+    }
+
+    inline double tarantula(const Spectrum &s) {
+        if (s.failed == 0) return 0;
+        const double failed = static_cast<double>(s.failed) / s.total_failed;
+        const double passed =
+            s.total_passed ? static_cast<double>(s.passed) / s.total_passed : 0;
+        return failed / (failed + passed);
+    }
+
+    // A line which is covered by all failed tests and no passed tests gets the
+    // largest score.
+    inline double dstar(const Spectrum &s, const unsigned int star = 2) {
+        const double denominator = static_cast<double>(s.passed + s.total_failed - s.failed);
+        const double numerator = std::pow(static_cast<double>(s.failed), star);
+        if (denominator > 0) return numerator / denominator;
+        return s.failed ? std::numeric_limits<double>::max() : 0;
+    }
+
+    inline double score(const Formula formula, const Spectrum &s, const unsigned int star = 2) {
+        switch (formula) {
+        case Formula::OCHIAI:
+            return ochiai(s);
+        case Formula::TARANTULA:
+            return tarantula(s);
+        default:
+            return dstar(s, star);
+        }
+    }
+
+    struct Suspiciousness {
+        size_t line_id;
+        double score;
+        size_t failed;
+        size_t passed;
+    };
+
+    // Higher scores come first and ties are broken by line ids so the ranking
+    // is deterministic.
+    inline bool operator<(const Suspiciousness &first, const Suspiciousness &second) {
+        if (first.score != second.score) return first.score > second.score;
+        return first.line_id < second.line_id;
+    }
+
+    // Rank the lines of a coverage matrix using the outcomes of its tests.
+    // Passed and failed tests are stored as bitsets, so the spectrum of a line
+    // is two popcount loops for a dense column or a few bit lookups for a
+    // sparse column. Lines which are not covered by any failed test have zero
+    // scores for all formulas and are skipped. A localizer keeps a reference
+    // to its coverage matrix, so the matrix must outlive it.
+    class Localizer {
+      public:
+        Localizer(clover::CoverageMatrix &&, const tap::TestOutcomes &) = delete;
+        Localizer(const clover::CoverageMatrix &data, const tap::TestOutcomes &outcomes)
+            : matrix(data), failed_tests(data.words_per_bitset(), 0),
+              passed_tests(data.words_per_bitset(), 0) {
+            const size_t ntests = std::min(matrix.number_of_tests(), outcomes.size());
+            for (size_t test_id = 0; test_id < ntests; ++test_id) {
+                const tap::Outcome outcome = outcomes.outcomes[test_id];
+                if (outcome >= tap::Outcome::FAILED) clover::set_bit(failed_tests, test_id);
+                if (outcome == tap::Outcome::PASSED) clover::set_bit(passed_tests, test_id);
+            }
+            total_failed = clover::popcount(failed_tests.data(), failed_tests.size());
+            total_passed = clover::popcount(passed_tests.data(), passed_tests.size());
+        }
+
+        size_t number_of_failed_tests() const { return total_failed; }
+        size_t number_of_passed_tests() const { return total_passed; }
+
+        // Return the spectrum of a line.
+        Spectrum spectrum(const size_t line_id) const {
+            return {matrix.count(line_id, failed_tests.data()),
+                    matrix.count(line_id, passed_tests.data()), total_failed, total_passed};
+        }
+
+        // Return the k most suspicious lines in ranking order.
+        std::vector<Suspiciousness> rank(const Formula formula, const size_t k,
+                                         const unsigned int star = 2) const {
+            std::priority_queue<Suspiciousness> top; // The worst candidate is on top.
+            if (k == 0 || total_failed == 0) return {};
+            for (size_t line_id = 0; line_id < matrix.number_of_lines(); ++line_id) {
+                const size_t failed = matrix.count(line_id, failed_tests.data());
+                if (failed == 0) continue;
+                const Spectrum s{failed, matrix.count(line_id, passed_tests.data()),
+                                 total_failed, total_passed};
+                const Suspiciousness item{line_id, score(formula, s, star), s.failed,
+                                          s.passed};
+                if (top.size() < k) {
+                    top.push(item);
+                } else if (item < top.top()) {
+                    top.pop();
+                    top.push(item);
+                }
+            }
+
+            std::vector<Suspiciousness> results(top.size());
+            for (auto it = results.rbegin(); it != results.rend(); ++it) {
+                *it = top.top();
+                top.pop();
+            }
+            return results;
+        }
+
+      private:
+        const clover::CoverageMatrix &matrix;
+        std::vector<clover::word_type> failed_tests;
+        std::vector<clover::word_type> passed_tests;
+        size_t total_failed;
+        size_t total_passed;
+    };
+} // namespace sbfl
@@ -0,0 +1,302 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "fmt/format.h"
+#include "fmt/ostream.h"
+
+#include "clover_parser.hpp"
+#include "coverage_matrix.hpp"
+#include "data_structures.hpp"
+
+// Generate synthetic clover and JUnit XML reports. The output only depends on
+// the given configuration so the same configuration always produce the same
+// bytes, which make the generated files usable as benchmark inputs.
+namespace generator {
+    // A splitmix64 random number generator. We do not use the std
+    // distributions because their output is not the same across standard
+    // library implementations.
+    class Random {
+      public:
+        explicit Random(const uint64_t seed) : state(seed) {}
+
+        uint64_t operator()() {
+            uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+        // Return a number in [0, bound).
+        unsigned int uniform(const unsigned int bound) {
+            return bound ? static_cast<unsigned int>((*this)() % bound) : 0;
+        }
+
+        // Return true with the probability of percent / 100.
+        bool chance(const unsigned int percent) { return uniform(100) < percent; }
+
+      private:
+        uint64_t state;
+    };
+
+    struct CloverConfig {
+        unsigned int packages = 8;
+        unsigned int files = 32;  // Number of files per package.
+        unsigned int lines = 256; // Number of line elements per file.
+
+        // The relative weights of stmt, method, and cond lines.
+        unsigned int stmt = 75;
+        unsigned int method = 10;
+        unsigned int cond = 15;
+
+        unsigned int covered = 80; // Percentage of covered lines.
+        uint64_t seed = 0;
+    };
+
+    struct JUnitConfig {
+        unsigned int suites = 64;
+        unsigned int tests = 32;   // Number of test cases per test suite.
+        unsigned int failures = 2; // Percentage of failed test cases.
+        uint64_t seed = 0;
+    };
+
+    struct MatrixConfig {
+        unsigned int tests = 5000;
+        unsigned int lines = 500000;
+        unsigned int covered = 2000;  // Lines covered by a test besides the common lines.
+        unsigned int common = 500;    // Lines covered by all tests, e.g. setup code.
+        unsigned int duplicates = 10; // Percentage of near duplicated tests.
+        uint64_t seed = 0;
+    };
+
+    // Generate line coverage data of a given file. Each file has its own random
+    // stream so we can regenerate a file without generating the whole report.
+    coverage::vector_type<coverage::LineCoverage> generate_lines(const CloverConfig &cfg,
+                                                                 const unsigned int pkg,
+                                                                 const unsigned int file) {
+        Random rng(cfg.seed ^ ((static_cast<uint64_t>(pkg) << 32) | file));
+        const unsigned int total = cfg.stmt + cfg.method + cfg.cond;
+        coverage::vector_type<coverage::LineCoverage> lines;
+        lines.reserve(cfg.lines);
+        unsigned int num = 0;
+        for (unsigned int idx = 0; idx < cfg.lines; ++idx) {
+            coverage::LineCoverage item;
+            num += 1 + rng.uniform(3);
+            item.num = num;
+            const unsigned int pick = rng.uniform(total);
+            const bool covered = rng.chance(cfg.covered);
+            if (pick < cfg.stmt) {
+                item.type = coverage::CoverageType::STMT;
+                item.count = covered ? 1 + rng.uniform(1000) : 0;
+            } else if (pick < cfg.stmt + cfg.method) {
+                item.type = coverage::CoverageType::METHOD;
+                item.count = covered ? 1 + rng.uniform(100) : 0;
+            } else {
+                item.type = coverage::CoverageType::COND;
+                item.truecount = covered ? rng.uniform(100) : 0;
+                item.falsecount = covered ? rng.uniform(100) : 0;
+            }
+            lines.push_back(item);
+        }
+        return lines;
+    }
+
+    coverage::FileMetrics file_metrics(const CloverConfig &cfg, const unsigned int pkg,
+                                       const unsigned int file) {
+        coverage::FileCoverage data;
+        data.lines = generate_lines(cfg, pkg, file);
+        coverage::FileMetrics results = coverage::compute_file_metrics(data);
+        results.classes = 1;
+        results.metrics.complexity = results.metrics.methods + results.metrics.conditionals / 2;
+        results.metrics.loc = data.lines.empty() ? 0 : data.lines.back().num;
+        results.metrics.ncloc = data.lines.size();
+        return results;
+    }
+
+    void accumulate(coverage::ClassMetrics &sum, const coverage::ClassMetrics &value) {
+        sum.elements += value.elements;
+        sum.coveredelements += value.coveredelements;
+        sum.statements += value.statements;
+        sum.coveredstatements += value.coveredstatements;
+        sum.conditionals += value.conditionals;
+        sum.coveredconditionals += value.coveredconditionals;
+        sum.methods += value.methods;
+        sum.coveredmethods += value.coveredmethods;
+        sum.complexity += value.complexity;
+        sum.loc += value.loc;
+        sum.ncloc += value.ncloc;
+    }
+
+    coverage::PackageMetrics package_metrics(const CloverConfig &cfg, const unsigned int pkg) {
+        coverage::PackageMetrics results;
+        results.files = cfg.files;
+        for (unsigned int file = 0; file < cfg.files; ++file) {
+            const coverage::FileMetrics metrics = file_metrics(cfg, pkg, file);
+            results.metrics.classes += metrics.classes;
+            accumulate(results.metrics.metrics, metrics.metrics);
+        }
+        return results;
+    }
+
+    void write_class_metrics(std::ostream &os, const coverage::ClassMetrics &metrics) {
+        fmt::print(os,
+                   "complexity=\"{}\" elements=\"{}\" coveredelements=\"{}\" "
+                   "conditionals=\"{}\" coveredconditionals=\"{}\" statements=\"{}\" "
+                   "coveredstatements=\"{}\" coveredmethods=\"{}\" methods=\"{}\" "
+                   "loc=\"{}\" ncloc=\"{}\"",
+                   metrics.complexity, metrics.elements, metrics.coveredelements,
+                   metrics.conditionals, metrics.coveredconditionals, metrics.statements,
+                   metrics.coveredstatements, metrics.coveredmethods, metrics.methods,
+                   metrics.loc, metrics.ncloc);
+    }
+
+    void write_line(std::ostream &os, const coverage::LineCoverage &line) {
+        if (line.type == coverage::CoverageType::COND) {
+            fmt::print(os,
+                       "        <line num=\"{}\" type=\"cond\" truecount=\"{}\" "
+                       "falsecount=\"{}\"/>\n",
+                       line.num, line.truecount, line.falsecount);
+        } else if (line.type == coverage::CoverageType::METHOD) {
+            fmt::print(os,
+                       "        <line num=\"{}\" count=\"{}\" type=\"method\" "
+                       "signature=\"method{}() : void\" visibility=\"public\"/>\n",
+                       line.num, line.count, line.num);
+        } else {
+            fmt::print(os, "        <line num=\"{}\" count=\"{}\" type=\"stmt\"/>\n", line.num,
+                       line.count);
+        }
+    }
+
+    // Write a clover XML report to a given stream.
+    void write_clover(std::ostream &os, const CloverConfig &cfg) {
+        std::vector<coverage::PackageMetrics> packages;
+        packages.reserve(cfg.packages);
+        coverage::ProjectMetrics project;
+        project.packages = cfg.packages;
+        for (unsigned int pkg = 0; pkg < cfg.packages; ++pkg) {
+            packages.emplace_back(package_metrics(cfg, pkg));
+            project.metrics.files += packages.back().files;
+            project.metrics.metrics.classes += packages.back().metrics.classes;
+            accumulate(project.metrics.metrics.metrics, packages.back().metrics.metrics);
+        }
+
+        const uint64_t timestamp = 1500000000 + cfg.seed % 100000000;
+        fmt::print(os, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+        fmt::print(os, "<coverage generated=\"{0}\" clover=\"4.2.0\">\n", timestamp);
+        fmt::print(os, "  <project timestamp=\"{0}\" name=\"synthetic\">\n", timestamp);
+        fmt::print(os, "    <metrics ");
+        write_class_metrics(os, project.metrics.metrics.metrics);
+        fmt::print(os, " packages=\"{}\" files=\"{}\" classes=\"{}\"/>\n", project.packages,
+                   project.metrics.files, project.metrics.metrics.classes);
+
+        for (unsigned int pkg = 0; pkg < cfg.packages; ++pkg) {
+            const coverage::PackageMetrics &pkg_metrics = packages[pkg];
+            fmt::print(os, "    <package name=\"pkg{}\">\n", pkg);
+            fmt::print(os, "      <metrics ");
+            write_class_metrics(os, pkg_metrics.metrics.metrics);
+            fmt::print(os, " files=\"{}\" classes=\"{}\"/>\n", pkg_metrics.files,
+                       pkg_metrics.metrics.classes);
+            for (unsigned int file = 0; file < cfg.files; ++file) {
+                const coverage::FileMetrics metrics = file_metrics(cfg, pkg, file);
+                fmt::print(os,
+                           "      <file name=\"File{1}.cpp\" "
+                           "path=\"/src/pkg{0}/File{1}.cpp\">\n",
+                           pkg, file);
+                fmt::print(os, "        <metrics ");
+                write_class_metrics(os, metrics.metrics);
+                fmt::print(os, " classes=\"{}\"/>\n", metrics.classes);
+                fmt::print(os, "        <class name=\"File{}\">\n", file);
+                fmt::print(os, "          <metrics ");
+                write_class_metrics(os, metrics.metrics);
+                fmt::print(os, "/>\n        </class>\n");
+                for (auto const &line : generate_lines(cfg, pkg, file)) {
+                    write_line(os, line);
+                }
+                fmt::print(os, "      </file>\n");
+            }
+            fmt::print(os, "    </package>\n");
+        }
+
+        fmt::print(os, "  </project>\n</coverage>\n");
+    }
+
+    // Write a JUnit XML report to a given stream.
+    void write_junit(std::ostream &os, const JUnitConfig &cfg) {
+        Random rng(cfg.seed);
+        fmt::print(os, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+        fmt::print(os, "<testsuites name=\"synthetic\">\n");
+        for (unsigned int suite = 0; suite < cfg.suites; ++suite) {
+            // Decide the outcome and duration of all tests upfront because
+            // testsuite attributes summarize them.
+            std::vector<bool> failed(cfg.tests);
+            std::vector<unsigned int> times(cfg.tests);
+            unsigned int nfailures = 0;
+            unsigned int total_time = 0;
+            for (unsigned int test = 0; test < cfg.tests; ++test) {
+                failed[test] = rng.chance(cfg.failures);
+                times[test] = rng.uniform(2000);
+                nfailures += failed[test];
+                total_time += times[test];
+            }
+
+            fmt::print(os,
+                       "  <testsuite name=\"Suite{}\" tests=\"{}\" failures=\"{}\" "
+                       "errors=\"0\" time=\"{}.{:03}\">\n",
+                       suite, cfg.tests, nfailures, total_time / 1000, total_time % 1000);
+            for (unsigned int test = 0; test < cfg.tests; ++test) {
+                fmt::print(os,
+                           "    <testcase name=\"test{1}\" classname=\"Suite{0}\" "
+                           "time=\"{2}.{3:03}\"",
+                           suite, test, times[test] / 1000, times[test] % 1000);
+                if (!failed[test]) {
+                    fmt::print(os, "/>\n");
+                    continue;
+                }
+                fmt::print(os,
+                           ">\n      <failure type=\"AssertionError\" "
+                           "message=\"expected {0} but got {1}\">Suite{2}.cpp:{3}: "
+                           "expected {0} but got {1}</failure>\n    </testcase>\n",
+                           test, test + 1, suite, rng.uniform(1000));
+            }
+            fmt::print(os, "  </testsuite>\n");
+        }
+        fmt::print(os, "</testsuites>\n");
+    }
+
+    // Generate a synthetic per-test coverage matrix. Each test covers the
+    // common lines and a random half of a window of 2 * covered lines. A near
+    // duplicated test copies the lines of an earlier test and replaces about
+    // 2% of them.
+    std::vector<clover::CoverageMatrix::Entry> generate_coverage(const MatrixConfig &cfg) {
+        using id_type = clover::CoverageMatrix::id_type;
+        Random rng(cfg.seed);
+        const unsigned int common = std::min(cfg.common, cfg.lines);
+        const unsigned int others = cfg.lines - common;
+        const unsigned int span = std::min(2 * cfg.covered, others);
+        std::vector<clover::CoverageMatrix::Entry> entries;
+        std::vector<size_t> offsets(1, 0);
+        for (unsigned int test = 0; test < cfg.tests; ++test) {
+            for (unsigned int line = 0; line < common; ++line) entries.push_back({test, line});
+            if (test > 0 && rng.chance(cfg.duplicates)) {
+                const unsigned int other = rng.uniform(test);
+                for (size_t idx = offsets[other]; idx < offsets[other + 1]; ++idx) {
+                    id_type line = entries[idx].line_id;
+                    if (line < common) continue;
+                    if (others && rng.chance(2)) line = common + rng.uniform(others);
+                    entries.push_back({test, line});
+                }
+            } else {
+                const unsigned int start = common + rng.uniform(others - span + 1);
+                for (unsigned int idx = 0; idx < span; ++idx) {
+                    if (rng.uniform(2)) entries.push_back({test, start + idx});
+                }
+            }
+            offsets.push_back(entries.size());
+        }
+        return entries;
+    }
+} // namespace generator
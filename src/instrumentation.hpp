@@ -0,0 +1,201 @@
+#pragma once
+
+#include <chrono>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "cereal/archives/binary.hpp"
+#include "cereal/archives/json.hpp"
+#include "cereal/archives/portable_binary.hpp"
+#include "cereal/archives/xml.hpp"
+#include "cereal/types/string.hpp"
+#include "cereal/types/vector.hpp"
+
+#include "utilities.hpp"
+
+// Phase timing and allocation statistics for parsers and the coverage
+// database. The statistics are only collected if CLOVER_INSTRUMENTATION is
+// defined, otherwise all Recorder methods are empty and will be optimized away.
+namespace instrumentation {
+    // The seconds of a phase are its exclusive time, i.e. the time of nested
+    // phases is not included, so the phases of a recorder sum up to the
+    // total time.
+    struct Phase {
+        std::string name;
+        double seconds;
+        size_t rows;
+        double rows_per_second;
+
+        Phase() noexcept : name(), seconds(), rows(), rows_per_second() {}
+        explicit Phase(const char *aname) : name(aname), seconds(), rows(), rows_per_second() {}
+        template <typename Archive> void serialize(Archive &ar) {
+            ar(cereal::make_nvp("name", name), cereal::make_nvp("seconds", seconds),
+               cereal::make_nvp("rows", rows),
+               cereal::make_nvp("rows_per_second", rows_per_second));
+        }
+    };
+
+    // Lookup statistics of a hash table. The number of probes is the total
+    // length of the bucket chains that were searched.
+    struct HashMap {
+        std::string name;
+        size_t lookups;
+        size_t probes;
+        size_t inserts;
+
+        HashMap() noexcept : name(), lookups(), probes(), inserts() {}
+        explicit HashMap(const char *aname) : name(aname), lookups(), probes(), inserts() {}
+        template <typename Archive> void serialize(Archive &ar) {
+            ar(cereal::make_nvp("name", name), cereal::make_nvp("lookups", lookups),
+               cereal::make_nvp("probes", probes), cereal::make_nvp("inserts", inserts));
+        }
+    };
+
+    struct Statistics {
+        std::vector<Phase> phases;
+        std::vector<HashMap> maps;
+        size_t bytes_allocated; // Bytes of container growth, map nodes, and arenas.
+        size_t peak_memory;     // Peak resident set size of the process.
+
+        Statistics() noexcept : phases(), maps(), bytes_allocated(), peak_memory() {}
+        template <typename Archive> void serialize(Archive &ar) {
+            ar(cereal::make_nvp("phases", phases), cereal::make_nvp("maps", maps),
+               cereal::make_nvp("bytes_allocated", bytes_allocated),
+               cereal::make_nvp("peak_memory", peak_memory));
+        }
+    };
+
+#ifdef CLOVER_INSTRUMENTATION
+    class Recorder {
+      public:
+        using clock_type = std::chrono::steady_clock;
+
+        // Accumulate the elapsed time of a scope into a given phase. The
+        // enclosing timer of the same recorder is paused while a nested timer
+        // is running. Timers of a recorder must be used by a single thread.
+        class Timer {
+          public:
+            Timer(Recorder &recorder, const size_t phase)
+                : owner(recorder), parent(recorder.current),
+                  phase(recorder.stats.phases[phase]), start(clock_type::now()) {
+                if (parent) parent->stop(start);
+                owner.current = this;
+            }
+            ~Timer() {
+                const clock_type::time_point now = clock_type::now();
+                stop(now);
+                owner.current = parent;
+                if (parent) parent->start = now;
+            }
+
+          private:
+            Recorder &owner;
+            Timer *parent;
+            Phase &phase;
+            clock_type::time_point start;
+
+            void stop(const clock_type::time_point now) {
+                const std::chrono::duration<double> elapsed = now - start;
+                phase.seconds += elapsed.count();
+            }
+        };
+
+        Recorder(std::initializer_list<const char *> phases,
+                 std::initializer_list<const char *> maps = {})
+            : current(nullptr) {
+            for (auto name : phases) stats.phases.emplace_back(name);
+            for (auto name : maps) stats.maps.emplace_back(name);
+        }
+
+        void add_rows(const size_t phase, const size_t rows) {
+            stats.phases[phase].rows += rows;
+        }
+
+        template <typename Map, typename Key>
+        void lookup(const size_t map, const Map &amap, const Key &key) {
+            HashMap &item = stats.maps[map];
+            ++item.lookups;
+            if (amap.bucket_count()) {
+                item.probes += amap.bucket_size(amap.bucket(key));
+            }
+        }
+
+        // Count an insert into a hash table and the memory of its node, i.e. a
+        // link to the next node and the value.
+        template <typename Map> void insert(const size_t map, const Map &) {
+            ++stats.maps[map].inserts;
+            stats.bytes_allocated += sizeof(void *) + sizeof(typename Map::value_type);
+        }
+
+        // Append a value to a container and account for its reallocation.
+        template <typename Container, typename Value>
+        void push_back(Container &container, Value &&value) {
+            const size_t capacity = container.capacity();
+            container.push_back(std::forward<Value>(value));
+            if (container.capacity() != capacity) {
+                stats.bytes_allocated +=
+                    container.capacity() * sizeof(typename Container::value_type);
+            }
+        }
+
+        // Append a default constructed value and return a reference to it.
+        template <typename Container>
+        typename Container::reference emplace_back(Container &container) {
+            const size_t capacity = container.capacity();
+            container.emplace_back();
+            if (container.capacity() != capacity) {
+                stats.bytes_allocated +=
+                    container.capacity() * sizeof(typename Container::value_type);
+            }
+            return container.back();
+        }
+
+        // Account for memory which is not owned by a recorded container, e.g.
+        // the chunks of an arena.
+        void allocate(const size_t bytes) { stats.bytes_allocated += bytes; }
+
+        const Statistics &statistics() {
+            for (auto &phase : stats.phases) {
+                phase.rows_per_second = phase.seconds > 0 ? phase.rows / phase.seconds : 0;
+            }
+            stats.peak_memory = utilities::peak_rss();
+            return stats;
+        }
+
+      private:
+        Statistics stats;
+        Timer *current; // The innermost running timer.
+    };
+#else
+    class Recorder {
+      public:
+        class Timer {
+          public:
+            Timer(Recorder &, const size_t) {}
+        };
+
+        Recorder(std::initializer_list<const char *>,
+                 std::initializer_list<const char *> = {}) {}
+        void add_rows(const size_t, const size_t) {}
+        template <typename Map, typename Key>
+        void lookup(const size_t, const Map &, const Key &) {}
+        template <typename Map> void insert(const size_t, const Map &) {}
+        template <typename Container, typename Value>
+        void push_back(Container &container, Value &&value) {
+            container.push_back(std::forward<Value>(value));
+        }
+        template <typename Container>
+        typename Container::reference emplace_back(Container &container) {
+            container.emplace_back();
+            return container.back();
+        }
+        void allocate(const size_t) {}
+        const Statistics &statistics() { return stats; }
+
+      private:
+        Statistics stats;
+    };
+#endif
+} // namespace instrumentation
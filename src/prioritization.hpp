@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+#include "coverage_matrix.hpp"
+#include "test_outcomes.hpp"
+
+// Test prioritization. Tests are ordered by the number of lines which they
+// cover in addition to the tests before them per second of runtime, so the
+// covered lines of a test suite are reached as early as possible.
+namespace prioritization {
+    struct Step {
+        size_t test_id;
+        size_t lines;   // Lines which are not covered by the tests before this one.
+        double seconds; // The predicted duration of this test.
+    };
+
+    struct Shard {
+        std::vector<size_t> tests; // Test ids in the prioritized order.
+        double seconds;            // The predicted duration of this shard.
+    };
+
+    class Scheduler {
+      public:
+        // Tests without a duration, e.g. tests which are not in the JUnit
+        // reports, take min_duration seconds. The matrix is referenced, so it
+        // must outlive the scheduler.
+        Scheduler(const clover::CoverageMatrix &data, const tap::TestOutcomes &outcomes,
+                  const double min_duration = 1e-3)
+            : matrix(data), durations(data.number_of_tests(), min_duration) {
+            const size_t ntests = std::min(matrix.number_of_tests(), outcomes.size());
+            for (size_t test_id = 0; test_id < ntests; ++test_id) {
+                const double seconds = outcomes.durations[test_id];
+                durations[test_id] = std::max(seconds, min_duration);
+            }
+        }
+
+        double duration(const size_t test_id) const { return durations[test_id]; }
+
+        // Return all tests in the greedy additional coverage order. The score
+        // of a test only decreases as more lines are covered, so a score which
+        // is computed in an earlier iteration is an upper bound of the current
+        // score. We only recompute the score of the top candidate of a lazy
+        // priority queue and select it if it is still on top, which needs a
+        // few score updates per iteration instead of one for every remaining
+        // test. Tests which add no coverage, i.e. all tests after the lines of
+        // the matrix are fully covered, are ordered by their total coverage
+        // per second.
+        std::vector<Step> operator()() const {
+            const size_t ntests = matrix.number_of_tests();
+            std::vector<Step> results;
+            results.reserve(ntests);
+            std::vector<clover::word_type> covered(
+                clover::number_of_words(matrix.number_of_lines()), 0);
+            std::vector<bool> is_selected(ntests, false);
+
+            std::priority_queue<Candidate> candidates;
+            for (size_t test_id = 0; test_id < ntests; ++test_id) {
+                const size_t lines = matrix.lines_of(test_id).size();
+                if (lines) candidates.push({lines / durations[test_id], lines, test_id, 0});
+            }
+
+            while (!candidates.empty()) {
+                Candidate item = candidates.top();
+                candidates.pop();
+                if (item.stamp != results.size()) {
+                    item.lines = additional_lines(item.test_id, covered);
+                    item.score = item.lines / durations[item.test_id];
+                    item.stamp = results.size();
+                    if (item.lines) candidates.push(item);
+                    continue;
+                }
+
+                for (const auto line_id : matrix.lines_of(item.test_id)) {
+                    clover::set_bit(covered, line_id);
+                }
+                is_selected[item.test_id] = true;
+                results.push_back({item.test_id, item.lines, durations[item.test_id]});
+            }
+
+            std::vector<Candidate> others;
+            for (size_t test_id = 0; test_id < ntests; ++test_id) {
+                if (is_selected[test_id]) continue;
+                const size_t lines = matrix.lines_of(test_id).size();
+                others.push_back({lines / durations[test_id], lines, test_id, 0});
+            }
+            std::sort(others.begin(), others.end(),
+                      [](const Candidate &first, const Candidate &second) {
+                          return second < first;
+                      });
+            for (const Candidate &item : others) {
+                results.push_back({item.test_id, 0, durations[item.test_id]});
+            }
+            return results;
+        }
+
+      private:
+        const clover::CoverageMatrix &matrix;
+        std::vector<double> durations;
+
+        struct Candidate {
+            double score; // Additional lines per second.
+            size_t lines;
+            size_t test_id;
+            size_t stamp; // The number of selected tests when the score is computed.
+
+            // The top of a priority queue is the candidate with the highest
+            // score and ties are broken by test ids so the order is
+            // deterministic.
+            bool operator<(const Candidate &other) const {
+                if (score != other.score) return score < other.score;
+                return test_id > other.test_id;
+            }
+        };
+
+        size_t additional_lines(const size_t test_id,
+                                const std::vector<clover::word_type> &covered) const {
+            size_t lines = 0;
+            for (const auto line_id : matrix.lines_of(test_id)) {
+                lines += !clover::test_bit(covered.data(), line_id);
+            }
+            return lines;
+        }
+    };
+
+    // Split a prioritized list of tests into n shards whose predicted times
+    // are balanced. Tests are assigned to the least loaded shard from the
+    // longest to the shortest one, which is within 4/3 of the optimal
+    // makespan, and each shard keeps the prioritized order of its tests.
+    inline std::vector<Shard> split(const std::vector<Step> &steps, const size_t n) {
+        std::vector<Shard> shards(std::max<size_t>(n, 1), Shard{{}, 0});
+        std::vector<size_t> positions(steps.size());
+        for (size_t idx = 0; idx < steps.size(); ++idx) positions[idx] = idx;
+        std::stable_sort(positions.begin(), positions.end(),
+                         [&steps](const size_t first, const size_t second) {
+                             return steps[first].seconds > steps[second].seconds;
+                         });
+
+        using Load = std::pair<double, size_t>;
+        std::priority_queue<Load, std::vector<Load>, std::greater<Load>> loads;
+        for (size_t idx = 0; idx < shards.size(); ++idx) loads.push({0, idx});
+        std::vector<std::vector<size_t>> assigned(shards.size());
+        for (const size_t pos : positions) {
+            Load item = loads.top();
+            loads.pop();
+            assigned[item.second].push_back(pos);
+            item.first += steps[pos].seconds;
+            loads.push(item);
+        }
+
+        for (size_t idx = 0; idx < shards.size(); ++idx) {
+            std::sort(assigned[idx].begin(), assigned[idx].end());
+            for (const size_t pos : assigned[idx]) {
+                shards[idx].tests.push_back(steps[pos].test_id);
+                shards[idx].seconds += steps[pos].seconds;
+            }
+        }
+        return shards;
+    }
+} // namespace prioritization
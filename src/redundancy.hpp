@@ -0,0 +1,246 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "coverage_matrix.hpp"
+
+// Find redundant tests, i.e. tests which cover nearly the same lines. The
+// Jaccard similarity of the coverage of two tests is estimated using MinHash
+// signatures, and candidate pairs are found by locality sensitive hashing,
+// so we do not have to compare all pairs of tests.
+namespace redundancy {
+    namespace detail {
+        // The splitmix64 finalizer.
+        inline uint64_t mix(uint64_t z) {
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+    } // namespace detail
+
+    // Return the Jaccard similarity of two sorted lists of line ids.
+    inline double jaccard(const clover::CoverageMatrix::Row &first,
+                          const clover::CoverageMatrix::Row &second) {
+        auto lhs = first.begin(), rhs = second.begin();
+        size_t common = 0;
+        while (lhs != first.end() && rhs != second.end()) {
+            if (*lhs < *rhs) {
+                ++lhs;
+            } else if (*rhs < *lhs) {
+                ++rhs;
+            } else {
+                ++common;
+                ++lhs;
+                ++rhs;
+            }
+        }
+        const size_t total = first.size() + second.size() - common;
+        return total ? static_cast<double>(common) / total : 1;
+    }
+
+    // MinHash signatures of the rows of a coverage matrix. Each hash function
+    // is a multiply shift hash (a * x + b) >> 32 with random 64-bit a and b,
+    // and the probability that two signatures agree at a given position is
+    // the Jaccard similarity of their rows. Signatures are stored in a
+    // test by hash matrix, so the inner loop over hash functions vectorizes.
+    class MinHash {
+      public:
+        using value_type = uint32_t;
+
+        MinHash(const clover::CoverageMatrix &matrix, const size_t hashes, const uint64_t seed)
+            : nhashes(std::max<size_t>(hashes, 1)), ntests(matrix.number_of_tests()),
+              multipliers(nhashes), increments(nhashes),
+              values(ntests * nhashes, std::numeric_limits<value_type>::max()) {
+            for (size_t idx = 0; idx < nhashes; ++idx) {
+                multipliers[idx] = detail::mix(seed + 2 * idx) | 1;
+                increments[idx] = detail::mix(seed + 2 * idx + 1);
+            }
+
+            const uint64_t *a = multipliers.data();
+            const uint64_t *b = increments.data();
+            for (size_t test_id = 0; test_id < ntests; ++test_id) {
+                value_type *signature = values.data() + test_id * nhashes;
+                for (const uint64_t line_id : matrix.lines_of(test_id)) {
+                    for (size_t idx = 0; idx < nhashes; ++idx) {
+                        const uint64_t value = (a[idx] * line_id + b[idx]) >> 32;
+                        signature[idx] =
+                            std::min(signature[idx], static_cast<value_type>(value));
+                    }
+                }
+            }
+        }
+
+        size_t number_of_hashes() const { return nhashes; }
+        size_t number_of_tests() const { return ntests; }
+
+        const value_type *signature(const size_t test_id) const {
+            return values.data() + test_id * nhashes;
+        }
+
+        // Return the estimated Jaccard similarity of two tests.
+        double similarity(const size_t first, const size_t second) const {
+            const value_type *lhs = signature(first);
+            const value_type *rhs = signature(second);
+            size_t count = 0;
+            for (size_t idx = 0; idx < nhashes; ++idx) count += lhs[idx] == rhs[idx];
+            return static_cast<double>(count) / nhashes;
+        }
+
+      private:
+        size_t nhashes;
+        size_t ntests;
+        std::vector<uint64_t> multipliers;
+        std::vector<uint64_t> increments;
+        std::vector<value_type> values;
+    };
+
+    struct Config {
+        size_t hashes = 128;
+        double threshold = 0.9; // The minimum Jaccard similarity of redundant tests.
+        double recall = 0.99;   // The probability that a pair at the threshold is found.
+        bool verify = true;     // Compute the exact similarity of candidate pairs.
+        uint64_t seed = 0;
+    };
+
+    // Tests which are connected by pairs whose similarities are not less than
+    // the threshold. The similarity is the smallest one of the pairs which
+    // merged the cluster, so other pairs of the cluster may be less similar.
+    struct Cluster {
+        std::vector<size_t> tests; // Sorted test ids.
+        double similarity;         // The smallest similarity of the merged pairs.
+    };
+
+    // Find clusters of redundant tests. Signatures are split into bands of
+    // rows, and two tests are a candidate pair if all rows of a band agree,
+    // which happens with the probability 1 - (1 - s^rows)^bands for a pair
+    // whose similarity is s. The number of rows is the largest one which
+    // finds a pair at the threshold with the given recall. Buckets of tests
+    // are found by sorting band hashes, and each member of a bucket is only
+    // paired with the previous member, so a bucket of m tests takes at most
+    // m - 1 checks and pairs which are already in the same cluster are
+    // skipped. Similar tests which are not neighbors in a bucket are only
+    // found through other pairs or other bands, so a cluster of pairs near
+    // the threshold may be split. Tests which do not cover any line are
+    // ignored.
+    class Detector {
+      public:
+        explicit Detector(const Config &config = Config())
+            : cfg(config), nrows(1), ncandidates(0), npairs(0) {
+            cfg.hashes = std::max<size_t>(cfg.hashes, 1);
+            for (size_t rows = 1; rows <= cfg.hashes; ++rows) {
+                if (cfg.hashes % rows != 0) continue;
+                const double bands = static_cast<double>(cfg.hashes / rows);
+                const double found = 1 - std::pow(1 - std::pow(cfg.threshold, rows), bands);
+                if (found >= cfg.recall) nrows = rows;
+            }
+        }
+
+        size_t number_of_rows() const { return nrows; }
+        size_t number_of_bands() const { return cfg.hashes / nrows; }
+
+        // Statistics of the last run.
+        size_t number_of_candidates() const { return ncandidates; }
+        size_t number_of_similar_pairs() const { return npairs; }
+
+        std::vector<Cluster> operator()(const clover::CoverageMatrix &matrix) {
+            const size_t ntests = matrix.number_of_tests();
+            const MinHash signatures(matrix, cfg.hashes, cfg.seed);
+            std::vector<size_t> parents(ntests);
+            std::vector<double> similarities(ntests, 1);
+            for (size_t idx = 0; idx < ntests; ++idx) parents[idx] = idx;
+            ncandidates = 0;
+            npairs = 0;
+
+            // Tests are sorted by their band keys and then by a random order
+            // which differs between bands, so a test is paired with another
+            // neighbor in each band.
+            struct Member {
+                uint64_t key;
+                uint64_t order;
+                size_t test_id;
+            };
+            std::vector<Member> buckets;
+            buckets.reserve(ntests);
+            for (size_t band = 0; band < number_of_bands(); ++band) {
+                buckets.clear();
+                const uint64_t salt = detail::mix(cfg.seed + band);
+                for (size_t test_id = 0; test_id < ntests; ++test_id) {
+                    if (matrix.lines_of(test_id).size() == 0) continue;
+                    const MinHash::value_type *rows = signatures.signature(test_id);
+                    uint64_t key = band;
+                    for (size_t idx = 0; idx < nrows; ++idx) {
+                        key = detail::mix(key ^ rows[band * nrows + idx]);
+                    }
+                    buckets.push_back({key, detail::mix(salt ^ test_id), test_id});
+                }
+                std::sort(buckets.begin(), buckets.end(),
+                          [](const Member &lhs, const Member &rhs) {
+                              return std::tie(lhs.key, lhs.order) <
+                                     std::tie(rhs.key, rhs.order);
+                          });
+
+                // Link each member of a bucket to the previous one.
+                for (size_t idx = 1; idx < buckets.size(); ++idx) {
+                    if (buckets[idx].key != buckets[idx - 1].key) continue;
+                    merge(matrix, signatures, buckets[idx - 1].test_id, buckets[idx].test_id,
+                          parents, similarities);
+                }
+            }
+
+            // Clusters are ordered by their smallest test ids.
+            std::vector<size_t> sizes(ntests, 0);
+            for (size_t test_id = 0; test_id < ntests; ++test_id) {
+                ++sizes[find(parents, test_id)];
+            }
+            std::vector<size_t> cluster_of(ntests, 0);
+            std::vector<Cluster> results;
+            for (size_t test_id = 0; test_id < ntests; ++test_id) {
+                const size_t root = find(parents, test_id);
+                if (sizes[root] < 2) continue;
+                if (root == test_id) {
+                    cluster_of[root] = results.size();
+                    results.push_back({{}, similarities[root]});
+                    results.back().tests.reserve(sizes[root]);
+                }
+                results[cluster_of[root]].tests.push_back(test_id);
+            }
+            return results;
+        }
+
+      private:
+        Config cfg;
+        size_t nrows;
+        size_t ncandidates;
+        size_t npairs;
+
+        static size_t find(std::vector<size_t> &parents, size_t idx) {
+            while (parents[idx] != idx) {
+                parents[idx] = parents[parents[idx]];
+                idx = parents[idx];
+            }
+            return idx;
+        }
+
+        void merge(const clover::CoverageMatrix &matrix, const MinHash &signatures,
+                   const size_t first, const size_t second, std::vector<size_t> &parents,
+                   std::vector<double> &similarities) {
+            size_t lhs = find(parents, first), rhs = find(parents, second);
+            if (lhs == rhs) return;
+            ++ncandidates;
+            const double similarity =
+                cfg.verify ? jaccard(matrix.lines_of(first), matrix.lines_of(second))
+                           : signatures.similarity(first, second);
+            if (similarity < cfg.threshold) return;
+            ++npairs;
+            if (rhs < lhs) std::swap(lhs, rhs);
+            parents[rhs] = lhs;
+            similarities[lhs] = std::min({similarities[lhs], similarities[rhs], similarity});
+        }
+    };
+} // namespace redundancy
@@ -0,0 +1,509 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fmt/format.h"
+#include "fmt/ostream.h"
+
+#include "data_structures.hpp"
+#include "instrumentation.hpp"
+#include "utilities.hpp"
+
+// Write annotated source reports of a clover coverage tree. Each file gets a
+// page with the hit counts of its lines, and each package and the project get
+// summary pages built from their metrics. Pages are written with fmt like the
+// synthetic reports of generator.hpp, so a page is streamed to disk line by
+// line instead of being built as a document first.
+namespace report {
+    enum class Format : uint8_t { HTML = 0, JSON = 1 };
+
+    // Statuses are ordered by severity, so the status of a line which has
+    // several coverage elements, e.g. a method and a statement, is the
+    // largest one.
+    enum class Status : uint8_t { NONE = 0, COVERED = 1, PARTIAL = 2, UNCOVERED = 3 };
+
+    struct LineSummary {
+        unsigned int num;
+        unsigned int count; // The largest hit count of the line.
+        unsigned int truecount;
+        unsigned int falsecount;
+        bool is_conditional;
+        Status status;
+    };
+
+    // A conditional is partially covered if only one of its branches is taken.
+    inline Status status_of(const coverage::LineCoverage &line) {
+        if (line.type == coverage::CoverageType::COND) {
+            if (line.truecount && line.falsecount) return Status::COVERED;
+            return (line.truecount || line.falsecount) ? Status::PARTIAL : Status::UNCOVERED;
+        }
+        return line.count ? Status::COVERED : Status::UNCOVERED;
+    }
+
+    // Return the coverage of the lines of a file sorted by line numbers.
+    inline std::vector<LineSummary> summarize(const coverage::FileCoverage &data) {
+        std::vector<LineSummary> lines;
+        lines.reserve(data.lines.size());
+        for (const auto &line : data.lines) {
+            lines.push_back({line.num, line.count, line.truecount, line.falsecount,
+                             line.type == coverage::CoverageType::COND, status_of(line)});
+        }
+        std::stable_sort(lines.begin(), lines.end(),
+                         [](const LineSummary &first, const LineSummary &second) {
+                             return first.num < second.num;
+                         });
+
+        std::vector<LineSummary> results;
+        results.reserve(lines.size());
+        for (const LineSummary &line : lines) {
+            if (results.empty() || results.back().num != line.num) {
+                results.push_back(line);
+                continue;
+            }
+            LineSummary &item = results.back();
+            item.count = std::max(item.count, line.count);
+            item.truecount = std::max(item.truecount, line.truecount);
+            item.falsecount = std::max(item.falsecount, line.falsecount);
+            item.is_conditional = item.is_conditional || line.is_conditional;
+            item.status = std::max(item.status, line.status);
+        }
+        return results;
+    }
+
+    namespace detail {
+        inline const char *status_name(const Status status) {
+            static const char *names[] = {"none", "covered", "partial", "uncovered"};
+            return names[static_cast<size_t>(status)];
+        }
+
+        inline const char *extension(const Format format) {
+            return format == Format::HTML ? "html" : "json";
+        }
+
+        inline std::string file_page(const size_t pkg, const size_t file, const Format format) {
+            return fmt::format("file-{}-{}.{}", pkg, file, extension(format));
+        }
+
+        inline std::string package_page(const size_t pkg, const Format format) {
+            return fmt::format("package-{}.{}", pkg, extension(format));
+        }
+
+        // Write a run of characters and replace the special characters of
+        // HTML with entities.
+        inline void write_html(std::ostream &os, const char *begin, const char *end) {
+            const char *run = begin;
+            for (const char *ptr = begin; ptr != end; ++ptr) {
+                const char *entity = nullptr;
+                switch (*ptr) {
+                case '<':
+                    entity = "&lt;";
+                    break;
+                case '>':
+                    entity = "&gt;";
+                    break;
+                case '&':
+                    entity = "&amp;";
+                    break;
+                case '"':
+                    entity = "&quot;";
+                    break;
+                default:
+                    continue;
+                }
+                os.write(run, ptr - run);
+                os << entity;
+                run = ptr + 1;
+            }
+            os.write(run, end - run);
+        }
+
+        template <typename String> void write_html(std::ostream &os, const String &value) {
+            write_html(os, value.data(), value.data() + value.size());
+        }
+
+        // Write a quoted JSON string.
+        template <typename String> void write_json(std::ostream &os, const String &value) {
+            const char *run = value.data();
+            const char *end = value.data() + value.size();
+            os.put('"');
+            for (const char *ptr = run; ptr != end; ++ptr) {
+                const unsigned char c = *ptr;
+                if (c >= 0x20 && c != '"' && c != '\\') continue;
+                os.write(run, ptr - run);
+                if (c == '"' || c == '\\') {
+                    os.put('\\');
+                    os.put(c);
+                } else {
+                    fmt::print(os, "\\u{:04x}", c);
+                }
+                run = ptr + 1;
+            }
+            os.write(run, end - run);
+            os.put('"');
+        }
+
+        inline void write_ratio(std::ostream &os, const int covered, const int total) {
+            if (total > 0) {
+                fmt::print(os, "<td>{}/{} ({:.1f}%)</td>", covered, total,
+                           100.0 * covered / total);
+            } else {
+                fmt::print(os, "<td>-</td>");
+            }
+        }
+
+        // Write the element, statement, conditional, and method coverage of a
+        // row of a summary table.
+        inline void write_metrics_cells(std::ostream &os, const coverage::ClassMetrics &data) {
+            write_ratio(os, data.coveredelements, data.elements);
+            write_ratio(os, data.coveredstatements, data.statements);
+            write_ratio(os, data.coveredconditionals, data.conditionals);
+            write_ratio(os, data.coveredmethods, data.methods);
+        }
+
+        inline void write_json_metrics(std::ostream &os, const coverage::ClassMetrics &data) {
+            fmt::print(os,
+                       "{{\"elements\": {}, \"coveredelements\": {}, \"statements\": {}, "
+                       "\"coveredstatements\": {}, \"conditionals\": {}, "
+                       "\"coveredconditionals\": {}, \"methods\": {}, \"coveredmethods\": {}, "
+                       "\"complexity\": {}, \"loc\": {}, \"ncloc\": {}}}",
+                       data.elements, data.coveredelements, data.statements,
+                       data.coveredstatements, data.conditionals, data.coveredconditionals,
+                       data.methods, data.coveredmethods, data.complexity, data.loc,
+                       data.ncloc);
+        }
+
+        template <typename String>
+        void write_html_header(std::ostream &os, const String &title) {
+            fmt::print(os, "<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n"
+                           "<link rel=\"stylesheet\" href=\"style.css\">\n<title>");
+            write_html(os, title);
+            fmt::print(os, "</title>\n</head>\n<body>\n<h1>");
+            write_html(os, title);
+            fmt::print(os, "</h1>\n");
+        }
+
+        inline void write_html_footer(std::ostream &os) {
+            fmt::print(os, "</body>\n</html>\n");
+        }
+
+        inline void write_table_header(std::ostream &os, const char *name) {
+            fmt::print(os, "<table class=\"summary\">\n<tr><th>{}</th><th>Elements</th>"
+                           "<th>Statements</th><th>Conditionals</th><th>Methods</th></tr>\n",
+                       name);
+        }
+
+        constexpr const char *stylesheet =
+            "body { font-family: sans-serif; }\n"
+            "table { border-collapse: collapse; }\n"
+            "table.summary td, table.summary th { border: 1px solid #ccc; padding: 2px 8px; }\n"
+            "table.source td { font-family: monospace; padding: 0 8px; }\n"
+            "td.code { white-space: pre; }\n"
+            "td.num, td.hits { text-align: right; color: #666; }\n"
+            "tr.covered td.code { background: #dfd; }\n"
+            "tr.partial td.code { background: #ffc; }\n"
+            "tr.uncovered td.code { background: #fdd; }\n";
+    } // namespace detail
+
+    struct Config {
+        Format format = Format::HTML;
+        std::string source_root; // A prefix of file paths which is used to read sources.
+        size_t threads = std::thread::hardware_concurrency();
+    };
+
+    // Write the report of a project into a directory. File pages are rendered
+    // by a pool of threads which take files from a shared counter. A thread
+    // only keeps the source of the file which it is rendering, so the memory
+    // usage does not depend on the number of files. Files whose sources cannot
+    // be read only show the lines which have coverage data.
+    class Writer {
+      public:
+        enum Phases : size_t { FILES = 0, SUMMARIES = 1 };
+
+        explicit Writer(const Config &config = Config())
+            : recorder({"files", "summaries"}), cfg(config) {
+            cfg.threads = std::max<size_t>(cfg.threads, 1);
+        }
+
+        // Create the output directory if it does not exist and write all
+        // pages. Throw std::runtime_error if a page cannot be written.
+        void operator()(const coverage::ProjectCoverage &project,
+                        const std::string &directory) {
+            utilities::make_directory(directory);
+            {
+                instrumentation::Recorder::Timer timer(recorder, FILES);
+                write_files(project, directory);
+            }
+
+            instrumentation::Recorder::Timer timer(recorder, SUMMARIES);
+            if (cfg.format == Format::HTML) {
+                write_page(directory + "/style.css",
+                           [](std::ostream &os) { os << detail::stylesheet; });
+            }
+            for (size_t pkg = 0; pkg < project.packages.size(); ++pkg) {
+                const auto &package = project.packages[pkg];
+                write_page(directory + "/" + detail::package_page(pkg, cfg.format),
+                           [&](std::ostream &os) { write_package(os, package, pkg); });
+                recorder.add_rows(SUMMARIES, 1);
+            }
+            write_page(directory + "/index." + detail::extension(cfg.format),
+                       [&](std::ostream &os) { write_project(os, project); });
+            recorder.add_rows(SUMMARIES, 1);
+        }
+
+        // Return the collected statistics. This is empty if
+        // CLOVER_INSTRUMENTATION is not defined.
+        const instrumentation::Statistics &statistics() { return recorder.statistics(); }
+
+      private:
+        instrumentation::Recorder recorder;
+        Config cfg;
+
+        template <typename Function> void write_page(const std::string &path, Function &&fn) {
+            char buffer[1 << 16];
+            std::ofstream os;
+            os.rdbuf()->pubsetbuf(buffer, sizeof(buffer));
+            os.open(path);
+            if (os) fn(os);
+            os.close();
+            if (!os) throw std::runtime_error("Cannot write " + path);
+        }
+
+        void write_files(const coverage::ProjectCoverage &project,
+                         const std::string &directory) {
+            struct Task {
+                size_t pkg;
+                size_t file;
+            };
+            std::vector<Task> tasks;
+            for (size_t pkg = 0; pkg < project.packages.size(); ++pkg) {
+                for (size_t file = 0; file < project.packages[pkg].files.size(); ++file) {
+                    tasks.push_back({pkg, file});
+                }
+            }
+
+            utilities::parallel_for(tasks.size(), cfg.threads, [&](const size_t idx) {
+                const coverage::PackageCoverage &package = project.packages[tasks[idx].pkg];
+                const std::string path =
+                    directory + "/" +
+                    detail::file_page(tasks[idx].pkg, tasks[idx].file, cfg.format);
+                write_page(path, [&](std::ostream &os) {
+                    write_file(os, package, package.files[tasks[idx].file], tasks[idx].pkg);
+                });
+            });
+            recorder.add_rows(FILES, tasks.size());
+        }
+
+        // Return the source of a file or an empty string if it cannot be read.
+        std::string read_source(const coverage::FileCoverage &data, bool &has_source) const {
+            has_source = true;
+            try {
+                return utilities::read_file(cfg.source_root + std::string(data.path.c_str()));
+            } catch (const std::runtime_error &) {
+                has_source = false;
+                return std::string();
+            }
+        }
+
+        void write_file(std::ostream &os, const coverage::PackageCoverage &package,
+                        const coverage::FileCoverage &data, const size_t pkg) const {
+            const std::vector<LineSummary> lines = summarize(data);
+            bool has_source;
+            const std::string source = read_source(data, has_source);
+            if (cfg.format == Format::HTML) {
+                write_html_file(os, package, data, pkg, lines, source, has_source);
+            } else {
+                write_json_file(os, package, data, lines, has_source);
+            }
+        }
+
+        void write_html_file(std::ostream &os, const coverage::PackageCoverage &package,
+                             const coverage::FileCoverage &data, const size_t pkg,
+                             const std::vector<LineSummary> &lines, const std::string &source,
+                             const bool has_source) const {
+            detail::write_html_header(os, data.path);
+            fmt::print(os, "<p><a href=\"index.html\">Project</a> / <a href=\"{}\">",
+                       detail::package_page(pkg, cfg.format));
+            detail::write_html(os, package.name);
+            fmt::print(os, "</a></p>\n");
+            detail::write_table_header(os, "File");
+            fmt::print(os, "<tr><td>");
+            detail::write_html(os, data.name);
+            fmt::print(os, "</td>");
+            detail::write_metrics_cells(os, data.metrics.metrics);
+            fmt::print(os, "</tr>\n</table>\n");
+            if (!has_source) fmt::print(os, "<p>The source file is not available.</p>\n");
+
+            // Lines after the end of the source, or all lines if there is no
+            // source, are written without code.
+            fmt::print(os, "<table class=\"source\">\n");
+            auto summary = lines.cbegin();
+            const char *ptr = source.data();
+            const char *end = source.data() + source.size();
+            unsigned int num = 0;
+            while (true) {
+                if (ptr != end) {
+                    ++num;
+                } else if (summary != lines.cend()) {
+                    num = std::max(num + 1, summary->num);
+                } else {
+                    break;
+                }
+                while (summary != lines.cend() && summary->num < num) ++summary;
+                const bool has_summary = summary != lines.cend() && summary->num == num;
+                if (ptr == end && !has_summary) continue;
+
+                const Status status = has_summary ? summary->status : Status::NONE;
+                fmt::print(os, "<tr class=\"{}\"><td class=\"num\">{}</td><td class=\"hits\">",
+                           detail::status_name(status), num);
+                if (has_summary && summary->is_conditional) {
+                    fmt::print(os, "{}/{}", summary->truecount, summary->falsecount);
+                } else if (has_summary) {
+                    fmt::print(os, "{}", summary->count);
+                }
+                fmt::print(os, "</td><td class=\"code\">");
+                const char *eol = std::find(ptr, end, '\n');
+                detail::write_html(os, ptr, eol);
+                fmt::print(os, "</td></tr>\n");
+                ptr = eol == end ? end : eol + 1;
+            }
+            fmt::print(os, "</table>\n");
+            detail::write_html_footer(os);
+        }
+
+        void write_json_file(std::ostream &os, const coverage::PackageCoverage &package,
+                             const coverage::FileCoverage &data,
+                             const std::vector<LineSummary> &lines,
+                             const bool has_source) const {
+            fmt::print(os, "{{\n  \"path\": ");
+            detail::write_json(os, data.path);
+            fmt::print(os, ",\n  \"name\": ");
+            detail::write_json(os, data.name);
+            fmt::print(os, ",\n  \"package\": ");
+            detail::write_json(os, package.name);
+            fmt::print(os, ",\n  \"has_source\": {},\n  \"classes\": {},\n  \"metrics\": ",
+                       has_source, data.metrics.classes);
+            detail::write_json_metrics(os, data.metrics.metrics);
+
+            fmt::print(os, ",\n  \"lines\": [");
+            const char *separator = "\n";
+            for (const LineSummary &line : lines) {
+                fmt::print(os, "{}    {{\"num\": {}, \"status\": \"{}\", ", separator, line.num,
+                           detail::status_name(line.status));
+                if (line.is_conditional) {
+                    fmt::print(os, "\"truecount\": {}, \"falsecount\": {}}}", line.truecount,
+                               line.falsecount);
+                } else {
+                    fmt::print(os, "\"count\": {}}}", line.count);
+                }
+                separator = ",\n";
+            }
+
+            for (const Status status : {Status::UNCOVERED, Status::PARTIAL}) {
+                fmt::print(os, "\n  ],\n  \"{}\": [", detail::status_name(status));
+                separator = "";
+                for (const LineSummary &line : lines) {
+                    if (line.status != status) continue;
+                    fmt::print(os, "{}{}", separator, line.num);
+                    separator = ", ";
+                }
+            }
+            fmt::print(os, "]\n}}\n");
+        }
+
+        void write_package(std::ostream &os, const coverage::PackageCoverage &package,
+                           const size_t pkg) const {
+            if (cfg.format == Format::JSON) {
+                fmt::print(os, "{{\n  \"name\": ");
+                detail::write_json(os, package.name);
+                fmt::print(os, ",\n  \"files\": {},\n  \"classes\": {},\n  \"metrics\": ",
+                           package.metrics.files, package.metrics.metrics.classes);
+                detail::write_json_metrics(os, package.metrics.metrics.metrics);
+                fmt::print(os, ",\n  \"pages\": [");
+                for (size_t file = 0; file < package.files.size(); ++file) {
+                    fmt::print(os, "{}\n    {{\"path\": ", file ? "," : "");
+                    detail::write_json(os, package.files[file].path);
+                    fmt::print(os, ", \"page\": \"{}\", \"metrics\": ",
+                               detail::file_page(pkg, file, cfg.format));
+                    detail::write_json_metrics(os, package.files[file].metrics.metrics);
+                    fmt::print(os, "}}");
+                }
+                fmt::print(os, "\n  ]\n}}\n");
+                return;
+            }
+
+            detail::write_html_header(os, package.name);
+            fmt::print(os, "<p><a href=\"index.html\">Project</a></p>\n");
+            detail::write_table_header(os, "Package");
+            fmt::print(os, "<tr><td>");
+            detail::write_html(os, package.name);
+            fmt::print(os, "</td>");
+            detail::write_metrics_cells(os, package.metrics.metrics.metrics);
+            fmt::print(os, "</tr>\n</table>\n");
+            detail::write_table_header(os, "File");
+            for (size_t file = 0; file < package.files.size(); ++file) {
+                fmt::print(os, "<tr><td><a href=\"{}\">",
+                           detail::file_page(pkg, file, cfg.format));
+                detail::write_html(os, package.files[file].path);
+                fmt::print(os, "</a></td>");
+                detail::write_metrics_cells(os, package.files[file].metrics.metrics);
+                fmt::print(os, "</tr>\n");
+            }
+            fmt::print(os, "</table>\n");
+            detail::write_html_footer(os);
+        }
+
+        void write_project(std::ostream &os, const coverage::ProjectCoverage &project) const {
+            const coverage::ClassMetrics &metrics = project.metrics.metrics.metrics.metrics;
+            if (cfg.format == Format::JSON) {
+                fmt::print(os, "{{\n  \"name\": ");
+                detail::write_json(os, project.name);
+                fmt::print(os, ",\n  \"timestamp\": ");
+                detail::write_json(os, project.timestamp);
+                fmt::print(os,
+                           ",\n  \"packages\": {},\n  \"files\": {},\n  \"classes\": {},\n"
+                           "  \"metrics\": ",
+                           project.metrics.packages, project.metrics.metrics.files,
+                           project.metrics.metrics.metrics.classes);
+                detail::write_json_metrics(os, metrics);
+                fmt::print(os, ",\n  \"pages\": [");
+                for (size_t pkg = 0; pkg < project.packages.size(); ++pkg) {
+                    fmt::print(os, "{}\n    {{\"name\": ", pkg ? "," : "");
+                    detail::write_json(os, project.packages[pkg].name);
+                    fmt::print(os, ", \"page\": \"{}\", \"metrics\": ",
+                               detail::package_page(pkg, cfg.format));
+                    const auto &package = project.packages[pkg];
+                    detail::write_json_metrics(os, package.metrics.metrics.metrics);
+                    fmt::print(os, "}}");
+                }
+                fmt::print(os, "\n  ]\n}}\n");
+                return;
+            }
+
+            detail::write_html_header(os, project.name);
+            detail::write_table_header(os, "Project");
+            fmt::print(os, "<tr><td>");
+            detail::write_html(os, project.name);
+            fmt::print(os, "</td>");
+            detail::write_metrics_cells(os, metrics);
+            fmt::print(os, "</tr>\n</table>\n");
+            detail::write_table_header(os, "Package");
+            for (size_t pkg = 0; pkg < project.packages.size(); ++pkg) {
+                fmt::print(os, "<tr><td><a href=\"{}\">",
+                           detail::package_page(pkg, cfg.format));
+                detail::write_html(os, project.packages[pkg].name);
+                fmt::print(os, "</a></td>");
+                detail::write_metrics_cells(os, project.packages[pkg].metrics.metrics.metrics);
+                fmt::print(os, "</tr>\n");
+            }
+            fmt::print(os, "</table>\n");
+            detail::write_html_footer(os);
+        }
+    };
+} // namespace report
@@ -0,0 +1,372 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "pugixml.hpp"
+
+#include "instrumentation.hpp"
+#include "xml_scanner.hpp"
+
+// A compile time mapping between structs and XML elements. A struct describes
+// its XML attributes, child elements, and text content by specializing
+// schema::Schema, which is similar to what a serialize method does for
+// cereal, i.e.
+//
+//   template <> struct Schema<Foo> : Leaf {
+//       static constexpr auto attributes() {
+//           return std::make_tuple(attribute("name", &Foo::name));
+//       }
+//   };
+//
+// Parser<Foo> then uses a perfect hash table, which is computed at compile
+// time, to dispatch attribute and child element names to struct fields.
+namespace schema {
+    template <typename T> struct Schema;
+
+    // A struct field which is stored in an XML attribute.
+    template <typename T, typename M> struct Attribute {
+        const char *name;
+        M T::*member;
+    };
+
+    // An attribute of a nested struct. This is used to flatten metrics
+    // structs whose fields are stored in the same XML element.
+    template <typename T, typename S, typename F> struct Nested {
+        S T::*member;
+        F field;
+    };
+
+    // A struct field which is stored in a child element. The field is either
+    // a struct with its own schema or a vector of them.
+    template <typename T, typename M> struct Child {
+        const char *name;
+        M T::*member;
+    };
+
+    // A struct field which holds the text content of an element.
+    template <typename T, typename M> struct Content { M T::*member; };
+
+    template <typename T, typename M>
+    constexpr Attribute<T, M> attribute(const char *name, M T::*member) {
+        return {name, member};
+    }
+
+    template <typename T, typename M>
+    constexpr Child<T, M> child(const char *name, M T::*member) {
+        return {name, member};
+    }
+
+    template <typename T, typename M> constexpr Content<T, M> content(M T::*member) {
+        return {member};
+    }
+
+    template <typename T, typename S, typename Tuple, size_t... Is>
+    constexpr auto nested(S T::*member, const Tuple &fields, std::index_sequence<Is...>) {
+        return std::make_tuple(Nested<T, S, typename std::tuple_element<Is, Tuple>::type>{
+            member, std::get<Is>(fields)}...);
+    }
+
+    // Embed the attributes of a nested struct.
+    template <typename T, typename S, typename Tuple>
+    constexpr auto nested(S T::*member, const Tuple &fields) {
+        using Indices = std::make_index_sequence<std::tuple_size<Tuple>::value>;
+        return nested(member, fields, Indices());
+    }
+
+    // Default children and content for elements which only have attributes.
+    struct Leaf {
+        static constexpr std::tuple<> children() { return std::tuple<>(); }
+        static constexpr std::tuple<> content() { return std::tuple<>(); }
+    };
+
+    template <typename T, typename M> constexpr const char *name_of(const Attribute<T, M> &f) {
+        return f.name;
+    }
+
+    template <typename T, typename S, typename F>
+    constexpr const char *name_of(const Nested<T, S, F> &f) {
+        return name_of(f.field);
+    }
+
+    template <typename T, typename M> constexpr const char *name_of(const Child<T, M> &f) {
+        return f.name;
+    }
+
+    // Names are hashed by their length and their first, middle, and last
+    // characters, so the hash of a name is computed in constant time.
+    constexpr uint32_t char_at(const char *str, const size_t pos) {
+        return static_cast<uint8_t>(str[pos]);
+    }
+
+    constexpr uint32_t key_of(const char *str, const size_t len) {
+        return len == 0 ? 0
+                        : static_cast<uint32_t>(len) ^ (char_at(str, 0) << 8) ^
+                              (char_at(str, len / 2) << 16) ^ (char_at(str, len - 1) << 24);
+    }
+
+    // A multiplicative hash whose multiplier is selected by a seed.
+    constexpr uint32_t hash(const char *str, const size_t len, const uint32_t seed) {
+        return (key_of(str, len) * (2654435761u + 2 * seed)) >> 20;
+    }
+
+    constexpr size_t length_of(const char *str) {
+        size_t len = 0;
+        while (str[len]) ++len;
+        return len;
+    }
+
+    constexpr size_t table_size(const size_t n) {
+        size_t size = 4;
+        while (size < 4 * n) size *= 2;
+        return size;
+    }
+
+    // A perfect hash table of N names. Slots store the index of a name plus
+    // one and zero means an empty slot.
+    template <size_t N> struct Table {
+        static constexpr size_t size = table_size(N);
+        static_assert(N < 255, "Too many fields");
+
+        uint32_t seed;
+        const char *names[N + 1];
+        size_t lengths[N + 1];
+        uint8_t slots[size];
+
+        // Return the index of a given name or N if it cannot be found.
+        size_t find(const char *name, const size_t len) const {
+            const uint8_t slot = slots[hash(name, len, seed) & (size - 1)];
+            if (slot == 0 || lengths[slot - 1] != len) return N;
+            return std::memcmp(names[slot - 1], name, len) == 0 ? slot - 1 : N;
+        }
+    };
+
+    // Search for a seed which maps all names to different slots.
+    template <typename Tuple, size_t... Is>
+    constexpr Table<sizeof...(Is)> make_table(const Tuple &fields, std::index_sequence<Is...>) {
+        constexpr size_t N = sizeof...(Is);
+        Table<N> table{};
+        const char *const names[N + 1] = {name_of(std::get<Is>(fields))..., nullptr};
+        for (size_t idx = 0; idx < N; ++idx) {
+            table.names[idx] = names[idx];
+            table.lengths[idx] = length_of(names[idx]);
+        }
+        for (size_t idx = 0; idx < N; ++idx) {
+            for (size_t other = idx + 1; other < N; ++other) {
+                if (key_of(names[idx], table.lengths[idx]) ==
+                    key_of(names[other], table.lengths[other])) {
+                    throw std::logic_error("Names must differ in their length or their first, "
+                                           "middle, or last character");
+                }
+            }
+        }
+        for (uint32_t seed = 0;; ++seed) {
+            bool is_perfect = true;
+            for (size_t slot = 0; slot < Table<N>::size; ++slot) table.slots[slot] = 0;
+            for (size_t idx = 0; idx < N && is_perfect; ++idx) {
+                const size_t slot =
+                    hash(names[idx], table.lengths[idx], seed) & (Table<N>::size - 1);
+                if (table.slots[slot]) {
+                    is_perfect = false;
+                } else {
+                    table.slots[slot] = static_cast<uint8_t>(idx + 1);
+                }
+            }
+            if (is_perfect) {
+                table.seed = seed;
+                return table;
+            }
+        }
+    }
+
+    template <typename Tuple> constexpr auto make_table(const Tuple &fields) {
+        return make_table(fields, std::make_index_sequence<std::tuple_size<Tuple>::value>());
+    }
+
+    // Decode attribute values which are stored in pugixml attributes.
+    inline void decode(const pugi::xml_attribute &attr, int &value) { value = attr.as_int(); }
+
+    inline void decode(const pugi::xml_attribute &attr, unsigned int &value) {
+        value = attr.as_uint();
+    }
+
+    inline void decode(const pugi::xml_attribute &attr, double &value) {
+        value = attr.as_double();
+    }
+
+    inline void decode(const pugi::xml_attribute &attr, bool &value) {
+        value = attr.as_int() != 0;
+    }
+
+    template <typename Traits, typename Alloc>
+    void decode(const pugi::xml_attribute &attr,
+                std::basic_string<char, Traits, Alloc> &value) {
+        value = attr.value();
+    }
+
+    // Decode attribute values which are found by the XML scanner.
+    inline void decode(const xml::Text &text, int &value) { value = xml::parse_int(text); }
+
+    inline void decode(const xml::Text &text, unsigned int &value) {
+        value = xml::parse_uint(text);
+    }
+
+    inline void decode(const xml::Text &text, double &value) {
+        char buffer[64];
+        const size_t len = text.size() < sizeof(buffer) ? text.size() : sizeof(buffer) - 1;
+        std::memcpy(buffer, text.begin, len);
+        buffer[len] = 0;
+        value = std::strtod(buffer, nullptr);
+    }
+
+    inline void decode(const xml::Text &text, bool &value) {
+        value = xml::parse_int(text) != 0;
+    }
+
+    template <typename Traits, typename Alloc>
+    void decode(const xml::Text &text, std::basic_string<char, Traits, Alloc> &value) {
+        xml::decode(text, value);
+    }
+
+    // Other types such as enums only need to define decode(xml::Text, T&).
+    template <typename M> void decode(const pugi::xml_attribute &attr, M &value) {
+        const char *str = attr.value();
+        decode(xml::Text(str, str + std::strlen(str)), value);
+    }
+
+    template <typename T, typename M, typename Value>
+    void assign(const Attribute<T, M> &field, T &obj, const Value &value) {
+        decode(value, obj.*(field.member));
+    }
+
+    template <typename T, typename S, typename F, typename Value>
+    void assign(const Nested<T, S, F> &field, T &obj, const Value &value) {
+        assign(field.field, obj.*(field.member), value);
+    }
+
+    template <typename T> struct is_sequence : std::false_type {};
+    template <typename E, typename A> struct is_sequence<std::vector<E, A>> : std::true_type {};
+
+    // A parser which is generated from the schema of T.
+    template <typename T> class Parser {
+      public:
+        using Attributes = decltype(Schema<T>::attributes());
+        using Children = decltype(Schema<T>::children());
+        static constexpr size_t number_of_attributes = std::tuple_size<Attributes>::value;
+        static constexpr size_t number_of_children = std::tuple_size<Children>::value;
+
+        static constexpr Attributes attributes = Schema<T>::attributes();
+        static constexpr Children children = Schema<T>::children();
+        static constexpr Table<number_of_attributes> attribute_table = make_table(attributes);
+        static constexpr Table<number_of_children> child_table = make_table(children);
+
+        // Assign an attribute to a field. Return false if the attribute is
+        // not a part of the schema.
+        template <typename Value>
+        static bool assign(T &obj, const char *name, const size_t len, const Value &value) {
+            const size_t idx = attribute_table.find(name, len);
+            if (idx == number_of_attributes) return false;
+            assign_attribute(obj, idx, value,
+                             std::make_index_sequence<number_of_attributes>());
+            return true;
+        }
+
+        // Parse an element and its children.
+        static void parse(const pugi::xml_node &node, T &obj,
+                          instrumentation::Recorder &recorder) {
+            for (auto attr = node.first_attribute(); attr; attr = attr.next_attribute()) {
+                const char *name = attr.name();
+                assign(obj, name, std::strlen(name), attr);
+            }
+
+            if (number_of_children) {
+                for (auto item = node.first_child(); item; item = item.next_sibling()) {
+                    const char *name = item.name();
+                    const size_t idx = child_table.find(name, std::strlen(name));
+                    if (idx == number_of_children) continue;
+                    parse_child(item, obj, idx, recorder,
+                                std::make_index_sequence<number_of_children>());
+                }
+            }
+
+            parse_content(node, obj, Schema<T>::content());
+        }
+
+        // Assign all attributes of a tag found by the XML scanner.
+        static void parse(const xml::Tag &tag, T &obj) {
+            xml::AttributeReader reader(tag);
+            xml::Text name, value;
+            while (reader.next(name, value)) {
+                assign(obj, name.begin, name.size(), value);
+            }
+        }
+
+      private:
+        // The chain of comparisons is turned into a jump table and the
+        // decoders are inlined.
+        template <typename Value>
+        static void assign_attribute(T &, const size_t, const Value &, std::index_sequence<>) {}
+
+        template <typename Value, size_t I, size_t... Is>
+        static void assign_attribute(T &obj, const size_t idx, const Value &value,
+                                     std::index_sequence<I, Is...>) {
+            if (idx == I) {
+                schema::assign(std::get<I>(attributes), obj, value);
+            } else {
+                assign_attribute(obj, idx, value, std::index_sequence<Is...>());
+            }
+        }
+
+        // Parse a child element into a struct.
+        template <typename M>
+        static void parse_into(const pugi::xml_node &node, M &value,
+                               instrumentation::Recorder &recorder, std::false_type) {
+            Parser<M>::parse(node, value, recorder);
+        }
+
+        // Parse a child element and append it to a vector.
+        template <typename M>
+        static void parse_into(const pugi::xml_node &node, M &values,
+                               instrumentation::Recorder &recorder, std::true_type) {
+            auto &value = recorder.emplace_back(values);
+            Parser<typename M::value_type>::parse(node, value, recorder);
+        }
+
+        static void parse_child(const pugi::xml_node &, T &, const size_t,
+                                instrumentation::Recorder &, std::index_sequence<>) {}
+
+        template <size_t I, size_t... Is>
+        static void parse_child(const pugi::xml_node &node, T &obj, const size_t idx,
+                                instrumentation::Recorder &recorder,
+                                std::index_sequence<I, Is...>) {
+            if (idx == I) {
+                auto &value = obj.*(std::get<I>(children).member);
+                parse_into(node, value, recorder,
+                           is_sequence<typename std::decay<decltype(value)>::type>());
+            } else {
+                parse_child(node, obj, idx, recorder, std::index_sequence<Is...>());
+            }
+        }
+
+        static void parse_content(const pugi::xml_node &, T &, const std::tuple<> &) {}
+
+        template <typename M>
+        static void parse_content(const pugi::xml_node &node, T &obj,
+                                  const std::tuple<Content<T, M>> &fields) {
+            obj.*(std::get<0>(fields).member) = node.first_child().value();
+        }
+    };
+
+    template <typename T> constexpr typename Parser<T>::Attributes Parser<T>::attributes;
+    template <typename T> constexpr typename Parser<T>::Children Parser<T>::children;
+    template <typename T>
+    constexpr Table<Parser<T>::number_of_attributes> Parser<T>::attribute_table;
+    template <typename T> constexpr Table<Parser<T>::number_of_children> Parser<T>::child_table;
+} // namespace schema
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <tuple>
 #include <vector>
 
 // XML parser
@@ -15,6 +16,9 @@
 #include "cereal/types/string.hpp"
 #include "cereal/types/vector.hpp"
 
+#include "instrumentation.hpp"
+#include "schema.hpp"
+
 namespace tap {
     struct TestFailure {
         std::string type;
@@ -28,9 +32,11 @@ namespace tap {
 
     struct TestCase {
         std::string name;
+        double time = 0; // Seconds
         std::vector<TestFailure> failures;
         template <typename Archive> void serialize(Archive &ar) {
-            ar(cereal::make_nvp("name", name), cereal::make_nvp("failures", failures));
+            ar(cereal::make_nvp("name", name), cereal::make_nvp("time", time),
+               cereal::make_nvp("failures", failures));
         }
     };
 
@@ -46,16 +52,62 @@ namespace tap {
                cereal::make_nvp("testcases", testcases));
         }
     };
+} // namespace tap
+
+// The XML schema of JUnit test reports.
+namespace schema {
+    template <> struct Schema<tap::TestFailure> : Leaf {
+        static constexpr auto attributes() {
+            return std::make_tuple(attribute("type", &tap::TestFailure::type),
+                                   attribute("message", &tap::TestFailure::message));
+        }
+        static constexpr auto content() {
+            return std::make_tuple(schema::content(&tap::TestFailure::data));
+        }
+    };
+
+    template <> struct Schema<tap::TestCase> : Leaf {
+        static constexpr auto attributes() {
+            return std::make_tuple(attribute("name", &tap::TestCase::name),
+                                   attribute("time", &tap::TestCase::time));
+        }
+        static constexpr auto children() {
+            return std::make_tuple(child("failure", &tap::TestCase::failures));
+        }
+    };
+
+    template <> struct Schema<tap::TestSuite> : Leaf {
+        static constexpr auto attributes() {
+            using tap::TestSuite;
+            return std::make_tuple(attribute("failures", &TestSuite::failures),
+                                   attribute("errors", &TestSuite::errors),
+                                   attribute("tests", &TestSuite::tests),
+                                   attribute("name", &TestSuite::name));
+        }
+        static constexpr auto children() {
+            return std::make_tuple(child("testcase", &tap::TestSuite::testcases));
+        }
+    };
+} // namespace schema
 
+namespace tap {
     class Parser {
       public:
         using TestResults = std::vector<TestSuite>;
+        enum Phases : size_t { LOAD = 0, DECODE = 1 };
+
+        Parser() : recorder({"load", "decode"}) {}
+
         TestResults operator()(const std::string &xmlfile) {
             TestResults results;
 
             // Read the XML file
             pugi::xml_document doc;
-            pugi::xml_parse_result result = doc.load_file(xmlfile.c_str());
+            pugi::xml_parse_result result;
+            {
+                instrumentation::Recorder::Timer timer(recorder, LOAD);
+                result = doc.load_file(xmlfile.c_str());
+            }
 			if (!result) {
 				throw std::runtime_error("Cannot parse " + xmlfile);
 			}
@@ -67,44 +119,22 @@ namespace tap {
             }
 
             // Parse test results
+            instrumentation::Recorder::Timer timer(recorder, DECODE);
             for (auto node = root_node.child("testsuite"); node;
                  node = node.next_sibling("testsuite")) {
-                results.emplace_back(parse_testsuite(node));
+                auto &testsuite = recorder.emplace_back(results);
+                schema::Parser<TestSuite>::parse(node, testsuite, recorder);
+                recorder.add_rows(DECODE, testsuite.testcases.size());
             }
 
             return results;
         }
 
-      private:
-        TestFailure parse_failure(const pugi::xml_node root_node) {
-            TestFailure failure;
-            failure.type = root_node.attribute("type").value();
-            failure.message = root_node.attribute("message").value();
-            failure.data = root_node.first_child().value();
-            return failure;
-        }
+        // Return the collected statistics. This is empty if
+        // CLOVER_INSTRUMENTATION is not defined.
+        const instrumentation::Statistics &statistics() { return recorder.statistics(); }
 
-        TestCase parse_testcase(const pugi::xml_node root_node) {
-            TestCase testcase;
-            testcase.name = root_node.attribute("name").value();
-            for (auto node = root_node.child("failure"); node;
-                 node = node.next_sibling("failure")) {
-                testcase.failures.emplace_back(parse_failure(node));
-            }
-            return testcase;
-        }
-
-        TestSuite parse_testsuite(const pugi::xml_node root_node) {
-            TestSuite testsuite;
-            testsuite.failures = root_node.attribute("failures").as_int();
-            testsuite.errors = root_node.attribute("errors").as_uint();
-            testsuite.tests = root_node.attribute("tests").as_uint();
-            testsuite.name = root_node.attribute("name").value();
-            for (auto node = root_node.child("testcase"); node;
-                 node = node.next_sibling("testcase")) {
-                testsuite.testcases.emplace_back(parse_testcase(node));
-            }
-            return testsuite;
-        }
+      private:
+        instrumentation::Recorder recorder;
     };
 } // namespace tap
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "cereal/archives/binary.hpp"
+#include "cereal/archives/json.hpp"
+#include "cereal/archives/portable_binary.hpp"
+#include "cereal/archives/xml.hpp"
+#include "cereal/types/vector.hpp"
+
+#include "clover.hpp"
+#include "instrumentation.hpp"
+#include "schema.hpp"
+#include "utilities.hpp"
+#include "xml_scanner.hpp"
+
+namespace tap {
+    // Outcomes are ordered by severity, so the outcome of a test case which
+    // has several failure, error, or skipped elements is the largest one.
+    enum class Outcome : uint8_t {
+        UNKNOWN = 0,
+        PASSED = 1,
+        SKIPPED = 2,
+        FAILED = 3,
+        ERROR = 4
+    };
+
+    // A test case which is found by scan_junit. Failure messages and data are
+    // skipped without being decoded.
+    struct TestRecord {
+        size_t suite; // An index into TestReport::suites.
+        std::string name;
+        double time; // Seconds
+        Outcome outcome;
+        TestRecord() : suite(), name(), time(), outcome(Outcome::PASSED) {}
+    };
+
+    // Test cases of a JUnit XML file.
+    struct TestReport {
+        std::vector<std::string> suites;
+        std::vector<TestRecord> records;
+    };
+
+    // Outcomes and durations of tests stored in columns which are indexed by
+    // the test ids of a clover::Database. Tests without results are UNKNOWN.
+    struct TestOutcomes {
+        std::vector<Outcome> outcomes;
+        std::vector<float> durations; // Seconds
+
+        size_t size() const { return outcomes.size(); }
+
+        void resize(const size_t n) {
+            outcomes.resize(n, Outcome::UNKNOWN);
+            durations.resize(n, 0);
+        }
+
+        // A test which is reported more than once, e.g. a rerun, keeps its
+        // last outcome and duration.
+        void set(const size_t test_id, const Outcome outcome, const float seconds) {
+            if (test_id >= size()) resize(test_id + 1);
+            outcomes[test_id] = outcome;
+            durations[test_id] = seconds;
+        }
+
+        bool is_failed(const size_t test_id) const {
+            return test_id < size() && outcomes[test_id] >= Outcome::FAILED;
+        }
+
+        template <typename Archive> void serialize(Archive &ar) {
+            ar(cereal::make_nvp("outcomes", outcomes),
+               cereal::make_nvp("durations", durations));
+        }
+    };
+} // namespace tap
+
+namespace schema {
+    template <> struct Schema<tap::TestRecord> : Leaf {
+        static constexpr auto attributes() {
+            return std::make_tuple(attribute("name", &tap::TestRecord::name),
+                                   attribute("time", &tap::TestRecord::time));
+        }
+    };
+} // namespace schema
+
+namespace tap {
+    namespace detail {
+        enum class Element : uint8_t { NONE, TESTSUITES, TESTSUITE, TESTCASE, OTHER };
+
+        inline void decode_name(const xml::Tag &tag, std::string &name) {
+            xml::AttributeReader reader(tag);
+            xml::Text key, value;
+            while (reader.next(key, value)) {
+                if (key.equal("name", 4)) {
+                    xml::decode(value, name);
+                    return;
+                }
+            }
+        }
+    } // namespace detail
+
+    // Scan a JUnit XML buffer and append its test cases to a report. Test
+    // cases of nested test suites belong to the innermost suite. Return false
+    // if the root element is neither testsuites nor testsuite and throw
+    // std::runtime_error if the buffer is not a valid XML document.
+    inline bool scan_junit(const char *begin, const char *end, TestReport &report) {
+        using detail::Element;
+        std::vector<Element> stack(1, Element::NONE);
+        std::vector<xml::Text> names(1); // The names of the open elements.
+        std::vector<size_t> suites;
+        xml::Tokenizer tokenizer(begin, end);
+        xml::Tag tag;
+        bool has_root = false;
+        while (tokenizer.next(tag)) {
+            if (tag.kind == xml::Tag::END) {
+                if (stack.size() < 2) throw std::runtime_error("Unexpected end tag");
+                if (!tag.name.equal(names.back().begin, names.back().size())) {
+                    throw std::runtime_error("Mismatched end tag");
+                }
+                if (stack.back() == Element::TESTSUITE) suites.pop_back();
+                stack.pop_back();
+                names.pop_back();
+                continue;
+            }
+
+            const Element parent = stack.back();
+            Element kind = Element::OTHER;
+            if (parent == Element::TESTCASE) {
+                Outcome outcome = Outcome::PASSED;
+                if (tag.name.equal("failure", 7)) outcome = Outcome::FAILED;
+                if (tag.name.equal("error", 5)) outcome = Outcome::ERROR;
+                if (tag.name.equal("skipped", 7)) outcome = Outcome::SKIPPED;
+                TestRecord &record = report.records.back();
+                record.outcome = std::max(record.outcome, outcome);
+            } else if (tag.name.equal("testsuite", 9) &&
+                       (parent == Element::NONE || parent == Element::TESTSUITES ||
+                        parent == Element::TESTSUITE)) {
+                kind = Element::TESTSUITE;
+                suites.push_back(report.suites.size());
+                report.suites.emplace_back();
+                detail::decode_name(tag, report.suites.back());
+            } else if (tag.name.equal("testsuites", 10) && parent == Element::NONE) {
+                kind = Element::TESTSUITES;
+            } else if (tag.name.equal("testcase", 8) && parent == Element::TESTSUITE) {
+                kind = Element::TESTCASE;
+                report.records.emplace_back();
+                TestRecord &record = report.records.back();
+                record.suite = suites.back();
+                schema::Parser<TestRecord>::parse(tag, record);
+            }
+
+            if (stack.size() == 1) {
+                if (kind == Element::OTHER) return false;
+                if (has_root) throw std::runtime_error("Multiple root elements");
+                has_root = true;
+            }
+
+            if (tag.kind == xml::Tag::START) {
+                stack.push_back(kind);
+                names.push_back(tag.name);
+            } else if (kind == Element::TESTSUITE) {
+                suites.pop_back();
+            }
+        }
+
+        if (stack.size() != 1) throw std::runtime_error("Unterminated element");
+        return has_root;
+    }
+
+    // Read a JUnit XML file.
+    inline TestReport read_junit(const std::string &xmlfile) {
+        std::string buffer;
+        try {
+            buffer = utilities::read_file(xmlfile);
+        } catch (const std::runtime_error &) {
+            throw std::runtime_error("Cannot parse " + xmlfile);
+        }
+
+        TestReport report;
+        bool is_junit;
+        try {
+            is_junit = scan_junit(buffer.data(), buffer.data() + buffer.size(), report);
+        } catch (const std::runtime_error &) {
+            throw std::runtime_error("Cannot parse " + xmlfile);
+        }
+        if (!is_junit) {
+            throw std::runtime_error(xmlfile + " is an invalid XML TAP file!");
+        }
+        return report;
+    }
+
+    // Import JUnit XML files into a clover::Database. Files are scanned in
+    // parallel without building a DOM, then suite and test names are interned
+    // as clover::Test{suite, test} in file order, so test ids do not depend
+    // on the number of threads. Files are processed in batches to bound the
+    // memory usage.
+    class Ingester {
+      public:
+        enum Phases : size_t { SCAN = 0, INTERN = 1 };
+        static constexpr size_t files_per_thread = 16;
+
+        explicit Ingester(const size_t threads = std::thread::hardware_concurrency())
+            : recorder({"scan", "intern"}), number_of_threads(std::max<size_t>(threads, 1)) {}
+
+        // Add the results of the given files to a TestOutcomes object whose
+        // columns cover all tests of db. Throw std::runtime_error if a file
+        // cannot be parsed.
+        template <typename Database>
+        void operator()(const std::vector<std::string> &files, Database &db,
+                        TestOutcomes &results) {
+            const size_t batch_size = number_of_threads * files_per_thread;
+            for (size_t first = 0; first < files.size(); first += batch_size) {
+                const size_t last = std::min(first + batch_size, files.size());
+                std::vector<TestReport> reports(last - first);
+                {
+                    instrumentation::Recorder::Timer timer(recorder, SCAN);
+                    scan(files, first, reports);
+                }
+
+                instrumentation::Recorder::Timer timer(recorder, INTERN);
+                for (const TestReport &report : reports) {
+                    for (const TestRecord &record : report.records) {
+                        const size_t test_id =
+                            db.get_test_index({report.suites[record.suite], record.name});
+                        results.set(test_id, record.outcome, static_cast<float>(record.time));
+                    }
+                    recorder.add_rows(SCAN, report.records.size());
+                    recorder.add_rows(INTERN, report.records.size());
+                }
+            }
+            results.resize(std::max(results.size(), db.get_tests().size()));
+        }
+
+        // Return the collected statistics. This is empty if
+        // CLOVER_INSTRUMENTATION is not defined.
+        const instrumentation::Statistics &statistics() { return recorder.statistics(); }
+
+      private:
+        instrumentation::Recorder recorder;
+        size_t number_of_threads;
+
+        // Scan files [first, first + reports.size()) in parallel.
+        void scan(const std::vector<std::string> &files, const size_t first,
+                  std::vector<TestReport> &reports) {
+            utilities::parallel_for(reports.size(), number_of_threads, [&](const size_t idx) {
+                reports[idx] = read_junit(files[first + idx]);
+            });
+        }
+    };
+} // namespace tap
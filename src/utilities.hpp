@@ -2,11 +2,24 @@
 
 #include "fmt/format.h"
 
-// System files for open, read, and close.
+// System files for open, read, close, and mkdir.
+#include <errno.h>
 #include <fcntl.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Resource usage of the current process.
+#include <sys/resource.h>
+
 namespace utilities {
     template <typename OArchive, typename T> void print(T &&data, const bool info = false) {
         std::stringstream output;
@@ -21,4 +34,76 @@ namespace utilities {
             fmt::print("Use memory: {}\n", output.str().size());
         }
     }
+
+    // Read the content of a given file into a string.
+    std::string read_file(const std::string &path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open " + path);
+        }
+
+        std::string buffer;
+        struct stat props;
+        if (!fstat(fd, &props) && props.st_size > 0) {
+            buffer.reserve(props.st_size);
+        }
+
+        char chunk[1 << 16];
+        while (true) {
+            const ssize_t nbytes = ::read(fd, chunk, sizeof(chunk));
+            if (nbytes < 0) {
+                ::close(fd);
+                throw std::runtime_error("Cannot read " + path);
+            }
+            if (nbytes == 0) break;
+            buffer.append(chunk, nbytes);
+        }
+        ::close(fd);
+        return buffer;
+    }
+
+    // Create a directory if it does not exist.
+    void make_directory(const std::string &path) {
+        if (::mkdir(path.c_str(), 0755) && errno != EEXIST) {
+            throw std::runtime_error("Cannot create " + path);
+        }
+    }
+
+    // Call fn(idx) for each idx in [0, n) using up to the given number of
+    // threads, which take indices from a shared counter. The calling thread is
+    // one of them. If calls throw, the exception of the smallest index is
+    // rethrown after all threads are joined.
+    template <typename Function>
+    void parallel_for(const size_t n, const size_t threads, Function &&fn) {
+        std::vector<std::exception_ptr> errors(n);
+        std::atomic<size_t> next(0);
+        auto worker = [&]() {
+            for (size_t idx = next++; idx < n; idx = next++) {
+                try {
+                    fn(idx);
+                } catch (...) {
+                    errors[idx] = std::current_exception();
+                }
+            }
+        };
+
+        const size_t nthreads = std::min(threads, n);
+        std::vector<std::thread> pool;
+        for (size_t idx = 1; idx < nthreads; ++idx) pool.emplace_back(worker);
+        worker();
+        for (auto &thread : pool) thread.join();
+
+        for (auto &error : errors) {
+            if (error) std::rethrow_exception(error);
+        }
+    }
+
+    // Return the peak resident set size of the current process in bytes.
+    size_t peak_rss() {
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage)) {
+            return 0;
+        }
+        return static_cast<size_t>(usage.ru_maxrss) * 1024; // ru_maxrss is in kilobytes.
+    }
 } // namespace utilities
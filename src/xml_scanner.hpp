@@ -0,0 +1,398 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+// Low level building blocks for hand written XML scanners. The tokenizer works
+// on a raw buffer and never allocates, a scanner for a given schema uses it to
+// find tags and only decodes the attributes it knows about.
+namespace xml {
+    // A view into the scanned buffer.
+    struct Text {
+        const char *begin;
+        const char *end;
+
+        Text() noexcept : begin(nullptr), end(nullptr) {}
+        Text(const char *b, const char *e) noexcept : begin(b), end(e) {}
+        size_t size() const { return end - begin; }
+        bool empty() const { return begin == end; }
+        bool equal(const char *str, const size_t len) const {
+            return size() == len && std::memcmp(begin, str, len) == 0;
+        }
+    };
+
+    // Find the first occurrence of c in [begin, end). Return end if c cannot
+    // be found.
+    inline const char *find_char(const char *begin, const char *end, const char c) {
+#if defined(__AVX2__)
+        const __m256i needle = _mm256_set1_epi8(c);
+        for (; begin + 32 <= end; begin += 32) {
+            const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(begin));
+            const __m256i matched = _mm256_cmpeq_epi8(chunk, needle);
+            const unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(matched));
+            if (mask) return begin + __builtin_ctz(mask);
+        }
+#elif defined(__SSE2__)
+        const __m128i needle = _mm_set1_epi8(c);
+        for (; begin + 16 <= end; begin += 16) {
+            const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(begin));
+            const __m128i matched = _mm_cmpeq_epi8(chunk, needle);
+            const unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(matched));
+            if (mask) return begin + __builtin_ctz(mask);
+        }
+#endif
+        for (; begin != end; ++begin) {
+            if (*begin == c) return begin;
+        }
+        return end;
+    }
+
+#if defined(__AVX2__)
+    constexpr size_t block_size = 32;
+#elif defined(__SSE2__)
+    constexpr size_t block_size = 16;
+#else
+    constexpr size_t block_size = 0;
+#endif
+
+    // Return a bit mask of '>', '"', and '\'' characters in the block_size
+    // bytes starting at a given pointer.
+    inline uint32_t tag_mask(const char *ptr) {
+#if defined(__AVX2__)
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(ptr));
+        const __m256i matched = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('>')),
+                            _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"'))),
+            _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\'')));
+        return static_cast<uint32_t>(_mm256_movemask_epi8(matched));
+#elif defined(__SSE2__)
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr));
+        const __m128i matched =
+            _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('>')),
+                                      _mm_cmpeq_epi8(chunk, _mm_set1_epi8('"'))),
+                         _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\'')));
+        return static_cast<uint32_t>(_mm_movemask_epi8(matched));
+#else
+        (void)ptr;
+        return 0;
+#endif
+    }
+
+    // Find the first occurrence of a given string in [begin, end).
+    inline const char *find_string(const char *begin, const char *end, const char *str,
+                                   const size_t len) {
+        while (true) {
+            begin = find_char(begin, end, str[0]);
+            if (static_cast<size_t>(end - begin) < len) return end;
+            if (std::memcmp(begin, str, len) == 0) return begin;
+            ++begin;
+        }
+    }
+
+    inline bool is_space(const char c) {
+        return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    }
+
+    inline const char *skip_spaces(const char *begin, const char *end) {
+        while (begin != end && is_space(*begin)) ++begin;
+        return begin;
+    }
+
+    // Parse an unsigned integer the same way pugixml does, i.e. leading spaces
+    // are ignored, hexadecimal numbers start with 0x, and the parsing stops at
+    // the first invalid character.
+    inline unsigned int parse_uint(const Text &text) {
+        const char *ptr = skip_spaces(text.begin, text.end);
+        if (ptr != text.end && *ptr == '+') ++ptr;
+        unsigned long long value = 0;
+        if (text.end - ptr > 2 && ptr[0] == '0' && (ptr[1] == 'x' || ptr[1] == 'X')) {
+            for (ptr += 2; ptr != text.end; ++ptr) {
+                const char c = *ptr;
+                unsigned int digit;
+                if (c >= '0' && c <= '9') {
+                    digit = c - '0';
+                } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+                    digit = (c | 0x20) - 'a' + 10;
+                } else {
+                    break;
+                }
+                value = value * 16 + digit;
+                if (value > UINT32_MAX) return UINT32_MAX;
+            }
+            return static_cast<unsigned int>(value);
+        }
+        for (; ptr != text.end; ++ptr) {
+            const unsigned int digit = static_cast<unsigned int>(*ptr - '0');
+            if (digit > 9) break;
+            value = value * 10 + digit;
+            if (value > UINT32_MAX) return UINT32_MAX;
+        }
+        return static_cast<unsigned int>(value);
+    }
+
+    // Parse a signed integer. Values which do not fit are clamped.
+    inline int parse_int(const Text &text) {
+        const char *ptr = skip_spaces(text.begin, text.end);
+        if (ptr == text.end || *ptr != '-') {
+            const unsigned int value = parse_uint(Text(ptr, text.end));
+            return value > INT32_MAX ? INT32_MAX : static_cast<int>(value);
+        }
+        const unsigned int value = parse_uint(Text(ptr + 1, text.end));
+        return value > 0x80000000u ? INT32_MIN : static_cast<int>(0u - value);
+    }
+
+    // Append a unicode code point to a string using UTF-8 encoding.
+    template <typename String> void append_utf8(String &out, const unsigned long code) {
+        if (code < 0x80) {
+            out.push_back(static_cast<char>(code));
+        } else if (code < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (code >> 6)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else if (code < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (code >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (code >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (code & 0x3F)));
+        }
+    }
+
+    // Decode the predefined and numeric character references of a given text.
+    template <typename String> void decode(const Text &text, String &out) {
+        const char *amp = find_char(text.begin, text.end, '&');
+        out.assign(text.begin, amp);
+        while (amp != text.end) {
+            const char *semicolon = find_char(amp, text.end, ';');
+            const Text entity(amp + 1, semicolon);
+            if (entity.equal("amp", 3)) {
+                out.push_back('&');
+            } else if (entity.equal("lt", 2)) {
+                out.push_back('<');
+            } else if (entity.equal("gt", 2)) {
+                out.push_back('>');
+            } else if (entity.equal("quot", 4)) {
+                out.push_back('"');
+            } else if (entity.equal("apos", 4)) {
+                out.push_back('\'');
+            } else if (entity.size() > 1 && entity.begin[0] == '#') {
+                const bool hex = entity.begin[1] == 'x';
+                const std::string digits(entity.begin + (hex ? 2 : 1), entity.end);
+                append_utf8(out, std::strtoul(digits.c_str(), nullptr, hex ? 16 : 10));
+            } else {
+                out.append(amp, semicolon == text.end ? semicolon : semicolon + 1);
+            }
+            if (semicolon == text.end) break;
+            const char *next = find_char(semicolon + 1, text.end, '&');
+            out.append(semicolon + 1, next);
+            amp = next;
+        }
+    }
+
+    // Decode character data which might contain comments, processing
+    // instructions, and CDATA sections.
+    template <typename String> void decode_content(const Text &text, String &out) {
+        out.clear();
+        String buffer(out.get_allocator());
+        const char *ptr = text.begin;
+        while (ptr != text.end) {
+            const char *lt = find_char(ptr, text.end, '<');
+            decode(Text(ptr, lt), buffer);
+            out.append(buffer.data(), buffer.size());
+            if (lt == text.end) break;
+            if (text.end - lt >= 9 && std::memcmp(lt, "<![CDATA[", 9) == 0) {
+                const char *cdata_end = find_string(lt + 9, text.end, "]]>", 3);
+                out.append(lt + 9, cdata_end);
+                ptr = cdata_end == text.end ? cdata_end : cdata_end + 3;
+            } else if (text.end - lt >= 4 && std::memcmp(lt, "<!--", 4) == 0) {
+                const char *comment_end = find_string(lt + 4, text.end, "-->", 3);
+                ptr = comment_end == text.end ? comment_end : comment_end + 3;
+            } else {
+                const char *gt = find_char(lt, text.end, '>');
+                ptr = gt == text.end ? gt : gt + 1;
+            }
+        }
+    }
+
+    // A start, end, or empty element tag.
+    struct Tag {
+        enum Kind : uint8_t { START, END, EMPTY };
+        static constexpr size_t max_quotes = 32;
+
+        Kind kind;
+        Text name;
+        Text attributes; // The text between the tag name and the closing '>'.
+        Text text;       // The character data before this tag.
+
+        // Positions of the opening and closing quotes of attribute values.
+        // The tokenizer records them while it looks for the end of a tag so
+        // attributes can be read without scanning the tag again.
+        const char *quotes[max_quotes];
+        size_t number_of_quotes; // Larger than max_quotes if there are too many.
+    };
+
+    // Iterate over the attributes of a tag.
+    class AttributeReader {
+      public:
+        explicit AttributeReader(const Tag &tag)
+            : current(tag.attributes.begin), end(tag.attributes.end),
+              quotes(tag.number_of_quotes <= Tag::max_quotes ? tag.quotes : nullptr),
+              quotes_end(quotes ? tag.quotes + tag.number_of_quotes : nullptr) {}
+
+        bool next(Text &name, Text &value) {
+            current = skip_spaces(current, end);
+            if (current == end) return false;
+
+            // Use quote positions found by the tokenizer if possible.
+            if (quotes != nullptr) {
+                if (quotes == quotes_end) throw std::runtime_error("Invalid attribute");
+                const char *name_end = quotes[0];
+                while (name_end != current && (name_end[-1] == '=' || is_space(name_end[-1]))) {
+                    --name_end;
+                }
+                name = Text(current, name_end);
+                value = Text(quotes[0] + 1, quotes[1]);
+                current = quotes[1] + 1;
+                quotes += 2;
+                return true;
+            }
+
+            const char *equal_sign = find_char(current, end, '=');
+            if (equal_sign == end) throw std::runtime_error("Invalid attribute");
+            const char *name_end = equal_sign;
+            while (name_end != current && is_space(name_end[-1])) --name_end;
+            const char *quote = skip_spaces(equal_sign + 1, end);
+            if (quote == end || (*quote != '"' && *quote != '\'')) {
+                throw std::runtime_error("Invalid attribute");
+            }
+            const char *value_end = find_char(quote + 1, end, *quote);
+            name = Text(current, name_end);
+            value = Text(quote + 1, value_end);
+            current = value_end + 1;
+            return true;
+        }
+
+      private:
+        const char *current;
+        const char *end;
+        const char *const *quotes;
+        const char *const *quotes_end;
+    };
+
+    // Split a buffer into tags. Comments, processing instructions, and
+    // document type declarations are skipped and CDATA sections are reported
+    // as character data.
+    class Tokenizer {
+      public:
+        Tokenizer(const char *b, const char *e) : current(b), end(e) {}
+
+        bool next(Tag &tag) {
+            const char *text_begin = current;
+            while (true) {
+                const char *lt = find_char(current, end, '<');
+                if (lt == end) {
+                    current = end;
+                    return false;
+                }
+                tag.text = Text(text_begin, lt);
+                if (end - lt > 1 && (lt[1] == '!' || lt[1] == '?')) {
+                    current = skip_markup(lt);
+                    continue;
+                }
+                return read_tag(lt, tag);
+            }
+        }
+
+      private:
+        const char *current;
+        const char *end;
+
+        const char *skip_markup(const char *lt) {
+            if (end - lt >= 4 && std::memcmp(lt, "<!--", 4) == 0) {
+                return close(find_string(lt + 4, end, "-->", 3), 3);
+            }
+            if (end - lt >= 9 && std::memcmp(lt, "<![CDATA[", 9) == 0) {
+                return close(find_string(lt + 9, end, "]]>", 3), 3);
+            }
+            if (lt[1] == '?') {
+                return close(find_string(lt + 2, end, "?>", 2), 2);
+            }
+            return close(find_char(lt + 2, end, '>'), 1);
+        }
+
+        const char *close(const char *ptr, const size_t len) {
+            if (ptr == end) throw std::runtime_error("Unterminated markup");
+            return ptr + len;
+        }
+
+        // Process a '>' or a quote character. Return true if it closes the tag.
+        static bool process(const char *ptr, Tag &tag, char &quote) {
+            const char c = *ptr;
+            if (quote) {
+                if (c != quote) return false;
+                quote = 0;
+            } else if (c == '>') {
+                return true;
+            } else {
+                quote = c;
+            }
+            if (tag.number_of_quotes < Tag::max_quotes) {
+                tag.quotes[tag.number_of_quotes] = ptr;
+            }
+            ++tag.number_of_quotes;
+            return false;
+        }
+
+        // Find the closing '>' while skipping quoted attribute values, which
+        // might contain '>'. Each block is classified using one SIMD
+        // comparison and only the special characters are visited.
+        const char *find_tag_end(const char *ptr, Tag &tag) {
+            char quote = 0;
+            tag.number_of_quotes = 0;
+            for (; block_size && ptr + block_size <= end; ptr += block_size) {
+                uint32_t mask = tag_mask(ptr);
+                while (mask) {
+                    const char *pos = ptr + __builtin_ctz(mask);
+                    if (process(pos, tag, quote)) return pos;
+                    mask &= mask - 1;
+                }
+            }
+            for (; ptr != end; ++ptr) {
+                const char c = *ptr;
+                if ((c == '>' || c == '"' || c == '\'') && process(ptr, tag, quote)) return ptr;
+            }
+            throw std::runtime_error("Unterminated tag");
+        }
+
+        bool read_tag(const char *lt, Tag &tag) {
+            const char *ptr = lt + 1;
+            tag.kind = Tag::START;
+            if (ptr != end && *ptr == '/') {
+                tag.kind = Tag::END;
+                ++ptr;
+            }
+            const char *name_begin = ptr;
+            while (ptr != end && !is_space(*ptr) && *ptr != '>' && *ptr != '/') ++ptr;
+            tag.name = Text(name_begin, ptr);
+
+            const char *attr_begin = ptr;
+            ptr = find_tag_end(ptr, tag);
+            const char *attr_end = ptr;
+            if (attr_end != attr_begin && attr_end[-1] == '/') {
+                tag.kind = Tag::EMPTY;
+                --attr_end;
+            }
+            tag.attributes = Text(attr_begin, attr_end);
+            current = ptr + 1;
+            return true;
+        }
+    };
+} // namespace xml
@@ -0,0 +1,132 @@
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <utility>
+
+#include "fmt/format.h"
+#include "pugixml.hpp"
+
+#include "clover_parser.hpp"
+#include "data_structures.hpp"
+#include "instrumentation.hpp"
+#include "utilities.hpp"
+
+#include "driver.hpp"
+
+// Count the calls of the global operator new.
+static size_t number_of_allocations = 0;
+
+void *operator new(size_t bytes) {
+    ++number_of_allocations;
+    void *ptr = std::malloc(bytes ? bytes : 1);
+    if (ptr == nullptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, size_t) noexcept { std::free(ptr); }
+
+// Parse the project node of a loaded clover document into a tree which uses
+// the given arena, or the global heap if the arena is null.
+coverage::ProjectCoverage parse(const pugi::xml_document &doc,
+                                std::shared_ptr<utilities::MonotonicArena> arena,
+                                instrumentation::Recorder &recorder) {
+    coverage::ProjectCoverage results(std::move(arena));
+    schema::Parser<coverage::ProjectCoverage>::parse(
+        doc.child("coverage").child("project"), results, recorder);
+    return results;
+}
+
+// Grow the strings and vectors of a file so they have to reallocate.
+void mutate(coverage::FileCoverage &file) {
+    file.path += "/a/path/which/is/too/long/for/the/small/string/buffer";
+    for (int idx = 0; idx < 100; ++idx) file.lines.emplace_back();
+    file.classes.emplace_back();
+    file.classes.back().name = "a class name which is too long for the small string buffer";
+}
+
+// Check that elements which are copied or moved out of a coverage tree stay
+// valid after the tree and its arena are destroyed, then compare the parse
+// time and the number of allocations of an arena tree and a heap tree.
+//   arena <clover.xml> [repeat]
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fmt::print("Usage: {} <clover.xml> [repeat]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    const unsigned int repeat = std::max<uint64_t>(driver::argument(argc, argv, 2, 10), 1);
+
+    pugi::xml_document doc;
+    if (!doc.load_file(argv[1])) {
+        fmt::print(stderr, "Invalid xml file: {}\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    instrumentation::Recorder recorder({"decode"});
+    const auto expected = parse(doc, nullptr, recorder);
+    if (expected.packages.empty() || expected.packages[0].files.empty() ||
+        expected.packages[0].files[0].classes.empty()) {
+        fmt::print(stderr, "The first file of the first package must have a class\n");
+        return EXIT_FAILURE;
+    }
+    const auto &first_package = expected.packages[0];
+    const auto &first_file = first_package.files[0];
+
+    // Assigning to an element with another allocator copies into that
+    // allocator, and the allocator-extended constructors do the same. Each
+    // element comes from its own tree which is destroyed right away.
+    using allocator_type = coverage::allocator_type;
+    auto tree = [&]() {
+        return parse(doc, std::make_shared<utilities::MonotonicArena>(), recorder);
+    };
+    coverage::FileCoverage copied, assigned;
+    coverage::PackageCoverage package;
+    copied = tree().packages[0].files[0];
+    assigned = std::move(tree().packages[0].files[0]);
+    package = std::move(tree().packages[0]);
+    auto constructed = coverage::FileCoverage(std::move(tree().packages[0].files[0]),
+                                              allocator_type());
+    auto klass = coverage::ClassCoverage(std::move(tree().packages[0].files[0].classes[0]),
+                                         allocator_type());
+
+    // A moved project takes over the arena of its source.
+    coverage::ProjectCoverage project = tree();
+    project = tree();
+
+    bool is_valid = copied == first_file && assigned == first_file &&
+                    constructed == first_file && package == first_package &&
+                    klass == first_file.classes[0] && project == expected;
+
+    // Mutate the elements after their trees are gone.
+    coverage::FileCoverage reference(first_file);
+    mutate(reference);
+    for (auto *file : {&copied, &assigned, &constructed, &package.files[0],
+                       &project.packages[0].files[0]}) {
+        mutate(*file);
+        is_valid = is_valid && *file == reference;
+    }
+    klass.name += " and a suffix";
+    is_valid = is_valid && klass.name.size() == first_file.classes[0].name.size() + 13;
+    fmt::print("{}\n", is_valid ? "OK" : "INVALID");
+
+    // Compare the arena tree with the baseline heap tree.
+    auto benchmark = [&](const char *name, const bool use_arena) {
+        size_t allocations = 0;
+        const double seconds = driver::measure([&]() {
+            for (unsigned int idx = 0; idx < repeat; ++idx) {
+                const size_t before = number_of_allocations;
+                auto arena =
+                    use_arena ? std::make_shared<utilities::MonotonicArena>() : nullptr;
+                const auto tree = parse(doc, std::move(arena), recorder);
+                allocations += number_of_allocations - before;
+            }
+        });
+        fmt::print("{}: {:.3f} ms, {} allocations per parse\n", name,
+                   seconds * 1000 / repeat, allocations / repeat);
+    };
+    benchmark("Arena", true);
+    benchmark("Heap", false);
+    fmt::print("Peak memory: {} bytes\n", utilities::peak_rss());
+    return is_valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,145 @@
+#include <fstream>
+#include <sstream>
+
+#include "celero/Celero.h"
+#include "fmt/format.h"
+#include "pugixml.hpp"
+
+#include "cereal/archives/binary.hpp"
+#include "cereal/archives/json.hpp"
+#include "cereal/archives/portable_binary.hpp"
+#include "cereal/archives/xml.hpp"
+#include "clover.hpp"
+#include "clover_parser.hpp"
+#include "generator.hpp"
+#include "tap_parser.hpp"
+
+// Use "benchmark -t results.csv" to save the results in a machine readable
+// format. The peak memory usage and rows/sec of each phase are reported by the
+// profile command.
+CELERO_MAIN
+
+namespace {
+    const std::string clover_file("clover_benchmark.xml");
+    const std::string junit_file("junit_benchmark.xml");
+    constexpr int number_of_samples = 10;
+    constexpr int number_of_iterations = 5;
+
+    // Generate input files once and share the parsed data between all
+    // benchmarks.
+    struct Data {
+        coverage::ProjectCoverage project;
+        std::string json;
+        std::string xml;
+        std::string binary;
+        std::string portable_binary;
+
+        Data() {
+            {
+                std::ofstream output(clover_file);
+                generator::write_clover(output, generator::CloverConfig());
+            }
+            {
+                std::ofstream output(junit_file);
+                generator::write_junit(output, generator::JUnitConfig());
+            }
+            coverage::CloverParser parser;
+            project = parser(clover_file);
+            json = encode<cereal::JSONOutputArchive>();
+            xml = encode<cereal::XMLOutputArchive>();
+            binary = encode<cereal::BinaryOutputArchive>();
+            portable_binary = encode<cereal::PortableBinaryOutputArchive>();
+        }
+
+        template <typename OArchive> std::string encode() const {
+            std::stringstream output;
+            {
+                OArchive oar(output);
+                oar(cereal::make_nvp("coverage", project));
+            }
+            return output.str();
+        }
+
+        template <typename IArchive>
+        coverage::ProjectCoverage decode(const std::string &buffer) const {
+            coverage::ProjectCoverage results;
+            std::stringstream input(buffer);
+            IArchive iar(input);
+            iar(cereal::make_nvp("coverage", results));
+            return results;
+        }
+    };
+
+    const Data &get_data() {
+        static const Data data;
+        return data;
+    }
+
+    class DataFixture : public celero::TestFixture {
+      public:
+        DataFixture() : data(get_data()) {}
+        const Data &data;
+    };
+} // namespace
+
+// Parsers
+BASELINE_F(parse, CloverParser, DataFixture, number_of_samples, number_of_iterations) {
+    coverage::CloverParser parser;
+    celero::DoNotOptimizeAway(parser(clover_file));
+}
+
+BENCHMARK_F(parse, Database, DataFixture, number_of_samples, number_of_iterations) {
+    clover::Database<size_t, unsigned int> db;
+    db.parse(0, clover_file.c_str());
+    celero::DoNotOptimizeAway(db.size());
+}
+
+BENCHMARK_F(parse, tap, DataFixture, number_of_samples, number_of_iterations) {
+    tap::Parser parser;
+    celero::DoNotOptimizeAway(parser(junit_file));
+}
+
+// Metrics
+BASELINE_F(metrics, compute_file_metrics, DataFixture, number_of_samples,
+           number_of_iterations) {
+    for (auto const &pkg : data.project.packages) {
+        for (auto const &afile : pkg.files) {
+            celero::DoNotOptimizeAway(coverage::compute_file_metrics(afile));
+        }
+    }
+}
+
+// Encode
+BASELINE_F(encode, JSON, DataFixture, number_of_samples, number_of_iterations) {
+    celero::DoNotOptimizeAway(data.encode<cereal::JSONOutputArchive>());
+}
+
+BENCHMARK_F(encode, XML, DataFixture, number_of_samples, number_of_iterations) {
+    celero::DoNotOptimizeAway(data.encode<cereal::XMLOutputArchive>());
+}
+
+BENCHMARK_F(encode, Binary, DataFixture, number_of_samples, number_of_iterations) {
+    celero::DoNotOptimizeAway(data.encode<cereal::BinaryOutputArchive>());
+}
+
+BENCHMARK_F(encode, PortableBinary, DataFixture, number_of_samples, number_of_iterations) {
+    celero::DoNotOptimizeAway(data.encode<cereal::PortableBinaryOutputArchive>());
+}
+
+// Decode
+BASELINE_F(decode, JSON, DataFixture, number_of_samples, number_of_iterations) {
+    celero::DoNotOptimizeAway(data.decode<cereal::JSONInputArchive>(data.json));
+}
+
+BENCHMARK_F(decode, XML, DataFixture, number_of_samples, number_of_iterations) {
+    celero::DoNotOptimizeAway(data.decode<cereal::XMLInputArchive>(data.xml));
+}
+
+BENCHMARK_F(decode, Binary, DataFixture, number_of_samples, number_of_iterations) {
+    celero::DoNotOptimizeAway(data.decode<cereal::BinaryInputArchive>(data.binary));
+}
+
+BENCHMARK_F(decode, PortableBinary, DataFixture, number_of_samples, number_of_iterations) {
+    celero::DoNotOptimizeAway(
+        data.decode<cereal::PortableBinaryInputArchive>(data.portable_binary));
+}
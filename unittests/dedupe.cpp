@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "coverage_matrix.hpp"
+#include "generator.hpp"
+#include "redundancy.hpp"
+
+#include "driver.hpp"
+
+// Find clusters of redundant tests in a synthetic coverage matrix and print
+// the number of candidate pairs and the run time. Clusters are compared with
+// those of an exhaustive pairwise search if there are at most 2000 tests.
+// Every cluster must be a part of an exhaustive cluster, and the fraction of
+// the redundant tests which are found is printed because a cluster of pairs
+// near the threshold may be split.
+//   dedupe [tests] [lines] [covered] [threshold percentage] [seed]
+// Return the clusters of all pairs whose similarities are not less than the
+// threshold.
+std::vector<std::vector<size_t>> exhaustive_search(const clover::CoverageMatrix &matrix,
+                                                   const double threshold) {
+    const size_t ntests = matrix.number_of_tests();
+    std::vector<size_t> labels(ntests);
+    for (size_t idx = 0; idx < ntests; ++idx) labels[idx] = idx;
+    for (size_t lhs = 0; lhs < ntests; ++lhs) {
+        if (matrix.lines_of(lhs).size() == 0) continue;
+        for (size_t rhs = lhs + 1; rhs < ntests; ++rhs) {
+            if (matrix.lines_of(rhs).size() == 0) continue;
+            if (redundancy::jaccard(matrix.lines_of(lhs), matrix.lines_of(rhs)) < threshold) {
+                continue;
+            }
+            const size_t from = std::max(labels[lhs], labels[rhs]);
+            const size_t to = std::min(labels[lhs], labels[rhs]);
+            for (auto &label : labels) {
+                if (label == from) label = to;
+            }
+        }
+    }
+
+    std::vector<std::vector<size_t>> clusters(ntests);
+    for (size_t idx = 0; idx < ntests; ++idx) clusters[labels[idx]].push_back(idx);
+    clusters.erase(std::remove_if(clusters.begin(), clusters.end(),
+                                  [](const auto &item) { return item.size() < 2; }),
+                   clusters.end());
+    return clusters;
+}
+
+int main(int argc, char *argv[]) {
+    generator::MatrixConfig cfg;
+    cfg.tests = driver::argument(argc, argv, 1, cfg.tests);
+    cfg.lines = driver::argument(argc, argv, 2, cfg.lines);
+    cfg.covered = driver::argument(argc, argv, 3, cfg.covered);
+    redundancy::Config params;
+    params.threshold = driver::argument(argc, argv, 4, 90) / 100.0;
+    cfg.seed = driver::argument(argc, argv, 5, 0);
+    params.seed = cfg.seed;
+
+    const clover::CoverageMatrix matrix(cfg.tests, cfg.lines,
+                                        generator::generate_coverage(cfg));
+
+    redundancy::Detector detector(params);
+    std::vector<redundancy::Cluster> clusters;
+    const double elapsed = driver::measure([&]() { clusters = detector(matrix); });
+
+    size_t redundant = 0;
+    double similarity = 1;
+    for (const auto &item : clusters) {
+        redundant += item.tests.size() - 1;
+        similarity = std::min(similarity, item.similarity);
+    }
+
+    fmt::print("Number of tests: {}\n", matrix.number_of_tests());
+    fmt::print("Number of covered pairs: {}\n", matrix.size());
+    fmt::print("Bands: {} of {} rows\n", detector.number_of_bands(),
+               detector.number_of_rows());
+    fmt::print("Candidate pairs: {}, similar pairs: {}\n", detector.number_of_candidates(),
+               detector.number_of_similar_pairs());
+    fmt::print("Clusters: {}, redundant tests: {}, the smallest similarity: {:.3f}\n",
+               clusters.size(), redundant, similarity);
+    fmt::print("Detection: {:.3f} seconds\n", elapsed);
+
+    if (matrix.number_of_tests() > 2000) return EXIT_SUCCESS;
+    std::vector<std::vector<size_t>> expected;
+    const double exhaustive_time =
+        driver::measure([&]() { expected = exhaustive_search(matrix, params.threshold); });
+    std::vector<size_t> labels(matrix.number_of_tests(), expected.size());
+    size_t expected_redundant = 0;
+    for (size_t idx = 0; idx < expected.size(); ++idx) {
+        for (const size_t test_id : expected[idx]) labels[test_id] = idx;
+        expected_redundant += expected[idx].size() - 1;
+    }
+    bool is_valid = true;
+    for (const auto &item : clusters) {
+        const size_t label = labels[item.tests.front()];
+        for (const size_t test_id : item.tests) {
+            is_valid = is_valid && label < expected.size() && labels[test_id] == label;
+        }
+    }
+    fmt::print("Exhaustive search: {:.3f} seconds, {}\n", exhaustive_time,
+               is_valid ? "OK" : "INVALID");
+    fmt::print("Found redundant tests: {} of {}\n", redundant, expected_redundant);
+    return is_valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+
+// Helpers shared by the command line drivers.
+namespace driver {
+    // Return the elapsed time of a function call in seconds.
+    template <typename Function> double measure(Function &&fn) {
+        auto const start = std::chrono::steady_clock::now();
+        fn();
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count();
+    }
+
+    // Return the positional argument at idx, or value if it is not given.
+    inline uint64_t argument(const int argc, char *argv[], const int idx,
+                             const uint64_t value) {
+        return idx < argc ? std::strtoull(argv[idx], nullptr, 10) : value;
+    }
+} // namespace driver
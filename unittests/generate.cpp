@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "fmt/format.h"
+
+#include "generator.hpp"
+
+#include "driver.hpp"
+
+// Generate synthetic reports for benchmarking. The stmt, method, and cond
+// arguments are the relative weights of the line types, and covered and
+// failures are percentages.
+//   generate clover <output> [packages] [files] [lines] [seed] [stmt] [method] [cond]
+//            [covered]
+//   generate junit <output> [suites] [tests] [seed] [failures]
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fmt::print("Usage: {0} clover <output> [packages] [files] [lines] [seed] [stmt] "
+                   "[method] [cond] [covered]\n"
+                   "       {0} junit <output> [suites] [tests] [seed] [failures]\n",
+                   argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    const std::string kind(argv[1]);
+    std::ofstream output(argv[2]);
+    if (!output) {
+        fmt::print(stderr, "Cannot open {}\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    if (kind == "clover") {
+        generator::CloverConfig cfg;
+        cfg.packages = driver::argument(argc, argv, 3, cfg.packages);
+        cfg.files = driver::argument(argc, argv, 4, cfg.files);
+        cfg.lines = driver::argument(argc, argv, 5, cfg.lines);
+        cfg.seed = driver::argument(argc, argv, 6, 0);
+        cfg.stmt = driver::argument(argc, argv, 7, cfg.stmt);
+        cfg.method = driver::argument(argc, argv, 8, cfg.method);
+        cfg.cond = driver::argument(argc, argv, 9, cfg.cond);
+        cfg.covered = std::min<uint64_t>(driver::argument(argc, argv, 10, cfg.covered), 100);
+        if (cfg.stmt + cfg.method + cfg.cond == 0) {
+            fmt::print(stderr, "The stmt, method, and cond weights cannot all be 0\n");
+            return EXIT_FAILURE;
+        }
+        generator::write_clover(output, cfg);
+    } else if (kind == "junit") {
+        generator::JUnitConfig cfg;
+        cfg.suites = driver::argument(argc, argv, 3, cfg.suites);
+        cfg.tests = driver::argument(argc, argv, 4, cfg.tests);
+        cfg.seed = driver::argument(argc, argv, 5, 0);
+        cfg.failures = std::min<uint64_t>(driver::argument(argc, argv, 6, cfg.failures), 100);
+        generator::write_junit(output, cfg);
+    } else {
+        fmt::print(stderr, "Unknown report type: {}\n", kind);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
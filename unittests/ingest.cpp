@@ -0,0 +1,180 @@
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "fmt/format.h"
+#include "pugixml.hpp"
+
+#include "clover.hpp"
+#include "test_outcomes.hpp"
+#include "utilities.hpp"
+
+#include "driver.hpp"
+
+// A JUnit report with error, skipped, and failure elements, nested test
+// suites, and a rerun test.
+const char *fixture = R"(<?xml version="1.0" encoding="UTF-8"?>
+<testsuites name="all">
+  <testsuite name="outer">
+    <testcase name="passed" time="0.5"/>
+    <testcase name="failed" time="1.25"><failure message="x">trace</failure></testcase>
+    <testsuite name="inner">
+      <testcase name="error" time="2"><error type="E"/></testcase>
+      <testcase name="skipped"><skipped/></testcase>
+      <testcase name="both" time="3"><failure/><error/><system-out>log</system-out></testcase>
+    </testsuite>
+    <testcase name="after &amp; inner" time="0.125"/>
+  </testsuite>
+  <testsuite name="rerun">
+    <testcase name="flaky" time="1"><failure/></testcase>
+    <testcase name="flaky" time="2"/>
+  </testsuite>
+</testsuites>
+)";
+
+// Append the test cases of a test suite and its nested suites to a report.
+// The outcome of a test case is the most severe one of its child elements,
+// which are the rules of tap::scan_junit.
+void read_suite(const pugi::xml_node suite, tap::TestReport &report) {
+    const size_t suite_idx = report.suites.size();
+    report.suites.emplace_back(suite.attribute("name").value());
+    for (auto node = suite.first_child(); node; node = node.next_sibling()) {
+        const std::string kind(node.name());
+        if (kind == "testsuite") read_suite(node, report);
+        if (kind != "testcase") continue;
+
+        tap::TestRecord record;
+        record.suite = suite_idx;
+        record.name = node.attribute("name").value();
+        record.time = node.attribute("time").as_double();
+        for (auto child = node.first_child(); child; child = child.next_sibling()) {
+            const std::string name(child.name());
+            tap::Outcome outcome = tap::Outcome::PASSED;
+            if (name == "failure") outcome = tap::Outcome::FAILED;
+            if (name == "error") outcome = tap::Outcome::ERROR;
+            if (name == "skipped") outcome = tap::Outcome::SKIPPED;
+            record.outcome = std::max(record.outcome, outcome);
+        }
+        report.records.push_back(record);
+    }
+}
+
+// Read a JUnit document using pugixml. Return false if it is not valid.
+bool read_report(const pugi::xml_document &doc, tap::TestReport &report) {
+    const pugi::xml_node root = doc.document_element();
+    const std::string name(root.name());
+    if (name == "testsuite") {
+        read_suite(root, report);
+        return true;
+    }
+    if (name != "testsuites") return false;
+    for (auto node = root.child("testsuite"); node; node = node.next_sibling("testsuite")) {
+        read_suite(node, report);
+    }
+    return true;
+}
+
+bool is_same_report(const tap::TestReport &first, const tap::TestReport &second) {
+    if (first.records.size() != second.records.size()) return false;
+    for (size_t idx = 0; idx < first.records.size(); ++idx) {
+        const auto &lhs = first.records[idx];
+        const auto &rhs = second.records[idx];
+        if (first.suites[lhs.suite] != second.suites[rhs.suite] || lhs.name != rhs.name ||
+            lhs.time != rhs.time || lhs.outcome != rhs.outcome) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Check tap::scan_junit against pugixml on the fixture, and check that both
+// reject the fixture if an end tag does not match its start tag.
+bool check_fixture() {
+    const std::string buffer(fixture);
+    tap::TestReport results, expected;
+    pugi::xml_document doc;
+    const bool is_valid = tap::scan_junit(buffer.data(), buffer.data() + buffer.size(),
+                                          results) &&
+                          doc.load_buffer(buffer.data(), buffer.size()) &&
+                          read_report(doc, expected) && is_same_report(expected, results);
+
+    using tap::Outcome;
+    const std::vector<Outcome> outcomes = {Outcome::PASSED, Outcome::FAILED, Outcome::ERROR,
+                                           Outcome::SKIPPED, Outcome::ERROR, Outcome::PASSED,
+                                           Outcome::FAILED, Outcome::PASSED};
+    bool is_expected = results.records.size() == outcomes.size();
+    for (size_t idx = 0; is_expected && idx < outcomes.size(); ++idx) {
+        is_expected = results.records[idx].outcome == outcomes[idx];
+    }
+    is_expected = is_expected && results.suites[results.records[2].suite] == "inner" &&
+                  results.suites[results.records[5].suite] == "outer";
+
+    std::string mismatched(buffer);
+    mismatched.replace(mismatched.find("</testcase>"), 11, "</testsuite>");
+    bool is_rejected = !doc.load_buffer(mismatched.data(), mismatched.size());
+    try {
+        tap::TestReport report;
+        tap::scan_junit(mismatched.data(), mismatched.data() + mismatched.size(), report);
+        is_rejected = false;
+    } catch (const std::runtime_error &) {
+    }
+    return is_valid && is_expected && is_rejected;
+}
+
+// Import JUnit XML files into a coverage database, cross validate the
+// outcomes and durations against a pugixml reader, and print the throughput.
+//   ingest [-j threads] <junit.xml>...
+int main(int argc, char *argv[]) {
+    int first = 1;
+    size_t threads = std::thread::hardware_concurrency();
+    if (argc > 2 && std::string(argv[1]) == "-j") {
+        threads = std::strtoul(argv[2], nullptr, 10);
+        first = 3;
+    }
+    if (first >= argc) return EXIT_SUCCESS;
+
+    const std::vector<std::string> files(argv + first, argv + argc);
+    clover::Database<size_t, unsigned int> db;
+    tap::TestOutcomes results;
+    tap::Ingester ingester(threads);
+    const double elapsed = driver::measure([&]() { ingester(files, db, results); });
+
+    // The outcomes and durations must be the same as those of the pugixml
+    // reader. A test which is reported more than once keeps its last result.
+    tap::TestOutcomes expected;
+    size_t testcases = 0;
+    bool is_same = check_fixture();
+    for (const auto &data_file : files) {
+        pugi::xml_document doc;
+        tap::TestReport report;
+        is_same = is_same && doc.load_file(data_file.c_str()) && read_report(doc, report);
+        for (const auto &record : report.records) {
+            const std::string &suite = report.suites[record.suite];
+            const size_t test_id = db.get_test_index({suite, record.name});
+            expected.set(test_id, record.outcome, static_cast<float>(record.time));
+            ++testcases;
+        }
+    }
+
+    is_same = is_same && expected.size() == results.size();
+    size_t failed = 0;
+    double total_time = 0;
+    for (size_t test_id = 0; is_same && test_id < results.size(); ++test_id) {
+        is_same = expected.outcomes[test_id] == results.outcomes[test_id] &&
+                  expected.durations[test_id] == results.durations[test_id];
+        failed += results.is_failed(test_id);
+        total_time += results.durations[test_id];
+    }
+
+    fmt::print("{}\n", is_same ? "OK" : "MISMATCH");
+    fmt::print("Number of files: {}\n", files.size());
+    fmt::print("Number of tests: {}\n", results.size());
+    fmt::print("Number of failed tests: {}\n", failed);
+    fmt::print("Total test time: {:.3f} seconds\n", total_time);
+    fmt::print("Ingestion: {:.3f} seconds, {:.0f} test cases/s\n", elapsed,
+               testcases / elapsed);
+    return is_same ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "coverage_matrix.hpp"
+#include "fault_localization.hpp"
+#include "generator.hpp"
+#include "test_outcomes.hpp"
+
+#include "driver.hpp"
+
+// Seed a fault into a synthetic coverage matrix, rank all lines with each
+// formula, and print the rank of the faulty line and the ranking time.
+//   localize [tests] [lines] [covered] [seed]
+int main(int argc, char *argv[]) {
+    generator::MatrixConfig cfg;
+    cfg.tests = driver::argument(argc, argv, 1, cfg.tests);
+    cfg.lines = driver::argument(argc, argv, 2, cfg.lines);
+    cfg.covered = driver::argument(argc, argv, 3, cfg.covered);
+    cfg.seed = driver::argument(argc, argv, 4, 0);
+
+    clover::CoverageMatrix matrix;
+    const double build_time = driver::measure([&]() {
+        auto entries = generator::generate_coverage(cfg);
+        matrix = clover::CoverageMatrix(cfg.tests, cfg.lines, std::move(entries));
+    });
+    if (matrix.number_of_tests() == 0) return EXIT_SUCCESS;
+
+    // The faulty line is a random line of a random test. Every test which
+    // covers it fails and about one in ten thousand other tests fails
+    // randomly.
+    generator::Random rng(cfg.seed + 1);
+    const auto row = matrix.lines_of(rng.uniform(cfg.tests));
+    if (row.size() == 0) return EXIT_SUCCESS;
+    const size_t fault = row.begin()[row.size() - 1 - rng.uniform(row.size() / 2)];
+    tap::TestOutcomes outcomes;
+    outcomes.resize(matrix.number_of_tests());
+    for (size_t test_id = 0; test_id < matrix.number_of_tests(); ++test_id) {
+        const auto lines = matrix.lines_of(test_id);
+        const bool is_covered = std::binary_search(lines.begin(), lines.end(), fault);
+        const bool is_failed = is_covered || rng.uniform(10000) == 0;
+        outcomes.set(test_id, is_failed ? tap::Outcome::FAILED : tap::Outcome::PASSED, 0);
+    }
+
+    sbfl::Localizer localizer(matrix, outcomes);
+    fmt::print("Number of tests: {} ({} failed)\n", matrix.number_of_tests(),
+               localizer.number_of_failed_tests());
+    fmt::print("Number of lines: {}\n", matrix.number_of_lines());
+    fmt::print("Number of covered pairs: {}\n", matrix.size());
+    fmt::print("Build matrix: {:.3f} seconds\n", build_time);
+
+    const std::vector<std::pair<const char *, sbfl::Formula>> formulas = {
+        {"Ochiai", sbfl::Formula::OCHIAI},
+        {"Tarantula", sbfl::Formula::TARANTULA},
+        {"DStar", sbfl::Formula::DSTAR}};
+    int status = EXIT_SUCCESS;
+    for (const auto &item : formulas) {
+        std::vector<sbfl::Suspiciousness> results;
+        const double rank_time =
+            driver::measure([&]() { results = localizer.rank(item.second, 10); });
+        // Lines with the same spectrum tie and the top 10 keeps the smallest
+        // line ids, so the faulty line is found if fewer than 10 lines have a
+        // larger score.
+        const double score = sbfl::score(item.second, localizer.spectrum(fault));
+        const bool is_found = !results.empty() && score >= results.back().score;
+        auto is_higher = [score](auto const &value) { return value.score > score; };
+        const auto rank = std::count_if(results.cbegin(), results.cend(), is_higher);
+        if (!is_found) status = EXIT_FAILURE;
+        fmt::print("{}: {:.3f} seconds, the faulty line {} is ", item.first, rank_time, fault);
+        if (is_found) {
+            fmt::print("ranked {} with score {:.4g}\n", rank + 1, score);
+        } else {
+            fmt::print("not in the top 10\n");
+        }
+    }
+    fmt::print("{}\n", status == EXIT_SUCCESS ? "OK" : "NOT FOUND");
+    return status;
+}
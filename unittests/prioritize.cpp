@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "fmt/format.h"
+
+#include "coverage_matrix.hpp"
+#include "generator.hpp"
+#include "prioritization.hpp"
+#include "test_outcomes.hpp"
+
+#include "driver.hpp"
+
+// Prioritize the tests of a synthetic coverage matrix, split them into shards,
+// and print the time which is needed to reach a given fraction of the covered
+// lines in the prioritized and the original order.
+//   prioritize [tests] [lines] [covered] [shards] [seed]
+// Return the time which is needed to cover the given fraction of lines.
+std::vector<double> coverage_times(const clover::CoverageMatrix &matrix,
+                                   const prioritization::Scheduler &scheduler,
+                                   const std::vector<size_t> &order,
+                                   const std::vector<double> &fractions) {
+    std::vector<clover::word_type> covered(clover::number_of_words(matrix.number_of_lines()),
+                                           0);
+    std::vector<std::pair<size_t, double>> progress; // Covered lines and elapsed time.
+    size_t lines = 0;
+    double seconds = 0;
+    for (const size_t test_id : order) {
+        for (const auto line_id : matrix.lines_of(test_id)) {
+            lines += !clover::test_bit(covered.data(), line_id);
+            clover::set_bit(covered, line_id);
+        }
+        seconds += scheduler.duration(test_id);
+        progress.emplace_back(lines, seconds);
+    }
+
+    std::vector<double> results;
+    for (const double fraction : fractions) {
+        const size_t target = static_cast<size_t>(fraction * lines);
+        auto it = std::find_if(progress.cbegin(), progress.cend(),
+                               [target](auto const &item) { return item.first >= target; });
+        results.push_back(target == 0 || it == progress.cend() ? 0 : it->second);
+    }
+    return results;
+}
+
+// Return the optimal makespan of a small instance by trying every assignment
+// of tests to shards. Tests are placed from the longest one, a test is not
+// placed into a shard whose load equals the load of an earlier shard, and
+// branches which cannot beat the best makespan are cut.
+double optimal_makespan(std::vector<double> durations, const size_t nshards) {
+    std::sort(durations.rbegin(), durations.rend());
+    std::vector<double> loads(nshards, 0);
+    double best = std::accumulate(durations.cbegin(), durations.cend(), 0.0);
+    std::function<void(size_t, double)> place = [&](const size_t idx, const double makespan) {
+        if (idx == durations.size()) {
+            best = std::min(best, makespan);
+            return;
+        }
+        for (size_t shard = 0; shard < nshards; ++shard) {
+            const auto last = loads.cbegin() + shard;
+            if (std::find(loads.cbegin(), last, loads[shard]) != last) continue;
+            const double load = loads[shard] + durations[idx];
+            if (load >= best) continue;
+            loads[shard] = load;
+            place(idx + 1, std::max(makespan, load));
+            loads[shard] -= durations[idx];
+        }
+    };
+    place(0, 0);
+    return best;
+}
+
+// Return the makespan of split for the given test durations.
+double split_makespan(const std::vector<double> &durations, const size_t nshards) {
+    std::vector<prioritization::Step> steps;
+    for (size_t idx = 0; idx < durations.size(); ++idx) {
+        steps.push_back({idx, 0, durations[idx]});
+    }
+    double makespan = 0;
+    for (const auto &shard : prioritization::split(steps, nshards)) {
+        makespan = std::max(makespan, shard.seconds);
+    }
+    return makespan;
+}
+
+// Check the makespan of split against the exact optimum of small random
+// instances. Durations are integers so the sums are exact.
+bool check_small_instances(const uint64_t seed) {
+    // The longest processing time rule is 7/6 of the optimum on this one.
+    bool is_valid = split_makespan({3, 3, 2, 2, 2}, 2) == 7 &&
+                    optimal_makespan({3, 3, 2, 2, 2}, 2) == 6;
+    generator::Random rng(seed);
+    for (int trial = 0; trial < 1000; ++trial) {
+        const size_t nshards = 1 + rng.uniform(4);
+        std::vector<double> durations(1 + rng.uniform(10));
+        for (auto &item : durations) item = 1 + rng.uniform(rng.chance(50) ? 10 : 1000);
+        const double optimum = optimal_makespan(durations, nshards);
+        const double bound = (4.0 / 3 - 1.0 / (3 * nshards)) * optimum;
+        is_valid = is_valid && split_makespan(durations, nshards) <= bound + 1e-9;
+    }
+    return is_valid;
+}
+
+int main(int argc, char *argv[]) {
+    generator::MatrixConfig cfg;
+    cfg.tests = driver::argument(argc, argv, 1, cfg.tests);
+    cfg.lines = driver::argument(argc, argv, 2, cfg.lines);
+    cfg.covered = driver::argument(argc, argv, 3, cfg.covered);
+    const size_t nshards = driver::argument(argc, argv, 4, 8);
+    cfg.seed = driver::argument(argc, argv, 5, 0);
+
+    const clover::CoverageMatrix matrix(cfg.tests, cfg.lines,
+                                        generator::generate_coverage(cfg));
+
+    // Most tests take milliseconds and a few slow tests take seconds.
+    generator::Random rng(cfg.seed + 1);
+    tap::TestOutcomes outcomes;
+    for (size_t test_id = 0; test_id < matrix.number_of_tests(); ++test_id) {
+        const float seconds = 1e-3f * (1 + rng.uniform(100)) * (rng.chance(5) ? 100 : 1);
+        outcomes.set(test_id, tap::Outcome::PASSED, seconds);
+    }
+
+    prioritization::Scheduler scheduler(matrix, outcomes);
+    std::vector<prioritization::Step> steps;
+    const double schedule_time = driver::measure([&]() { steps = scheduler(); });
+    std::vector<prioritization::Shard> shards;
+    const double split_time =
+        driver::measure([&]() { shards = prioritization::split(steps, nshards); });
+
+    // The prioritized order is a permutation of all tests and its additional
+    // lines sum up to the number of covered lines.
+    std::vector<size_t> order, original;
+    size_t additional = 0, useful = 0;
+    double total_time = 0, longest = 0;
+    for (const auto &item : steps) {
+        order.push_back(item.test_id);
+        additional += item.lines;
+        useful += item.lines > 0;
+        total_time += item.seconds;
+        longest = std::max(longest, item.seconds);
+    }
+    for (size_t test_id = 0; test_id < matrix.number_of_tests(); ++test_id) {
+        original.push_back(test_id);
+    }
+    std::vector<size_t> sorted_order(order);
+    std::sort(sorted_order.begin(), sorted_order.end());
+    std::vector<clover::word_type> covered(clover::number_of_words(matrix.number_of_lines()),
+                                           0);
+    size_t lines = 0;
+    for (size_t test_id = 0; test_id < matrix.number_of_tests(); ++test_id) {
+        for (const auto line_id : matrix.lines_of(test_id)) {
+            lines += !clover::test_bit(covered.data(), line_id);
+            clover::set_bit(covered, line_id);
+        }
+    }
+    bool is_valid = sorted_order == original && additional == lines;
+
+    // Every test is in one shard. A greedy schedule ends at most one test
+    // after the average load, so the longest shard is not longer than the
+    // lower bound of the optimal makespan plus the longest test. The 4/3
+    // guarantee is relative to the optimum and is checked on small instances.
+    size_t sharded = 0;
+    double makespan = 0;
+    for (const auto &shard : shards) {
+        sharded += shard.tests.size();
+        makespan = std::max(makespan, shard.seconds);
+    }
+    const double lower_bound = std::max(total_time / shards.size(), longest);
+    is_valid = is_valid && sharded == steps.size() &&
+               makespan <= lower_bound + longest + 1e-9 && check_small_instances(cfg.seed);
+
+    fmt::print("{}\n", is_valid ? "OK" : "INVALID");
+    fmt::print("Number of tests: {} ({} add coverage)\n", matrix.number_of_tests(), useful);
+    fmt::print("Number of covered lines: {}\n", lines);
+    fmt::print("Total test time: {:.3f} seconds\n", total_time);
+    fmt::print("Prioritize: {:.3f} seconds\n", schedule_time);
+    fmt::print("Split: {:.3f} seconds\n", split_time);
+
+    const std::vector<double> fractions = {0.5, 0.9, 0.99, 1.0};
+    const auto prioritized = coverage_times(matrix, scheduler, order, fractions);
+    const auto baseline = coverage_times(matrix, scheduler, original, fractions);
+    for (size_t idx = 0; idx < fractions.size(); ++idx) {
+        fmt::print("{:.0f}% coverage: {:.3f} seconds, {:.3f} seconds in the original order\n",
+                   fractions[idx] * 100, prioritized[idx], baseline[idx]);
+    }
+
+    fmt::print("Shards: {}, the longest {:.3f} seconds, the lower bound {:.3f} seconds\n",
+               shards.size(), makespan, lower_bound);
+    return is_valid ? EXIT_SUCCESS : EXIT_FAILURE;
+}
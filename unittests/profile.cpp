@@ -0,0 +1,131 @@
+#include <fstream>
+#include <sstream>
+
+#include "fmt/format.h"
+#include "pugixml.hpp"
+
+#include "cereal/archives/binary.hpp"
+#include "cereal/archives/json.hpp"
+#include "cereal/archives/portable_binary.hpp"
+#include "cereal/archives/xml.hpp"
+#include "clover.hpp"
+#include "clover_parser.hpp"
+#include "tap_parser.hpp"
+#include "instrumentation.hpp"
+#include "utilities.hpp"
+
+#include "driver.hpp"
+
+// The result of one measured phase.
+struct Measurement {
+    std::string name;
+    size_t rows;
+    double seconds;
+    double rows_per_second;
+    size_t peak_rss;
+    template <typename Archive> void serialize(Archive &ar) {
+        ar(cereal::make_nvp("name", name), cereal::make_nvp("rows", rows),
+           cereal::make_nvp("seconds", seconds),
+           cereal::make_nvp("rows_per_second", rows_per_second),
+           cereal::make_nvp("peak_rss", peak_rss));
+    }
+};
+
+template <typename Function> Measurement measure(const std::string &name, Function &&fn) {
+    size_t rows = 0;
+    const double seconds = driver::measure([&]() { rows = fn(); });
+    return {name, rows, seconds, seconds > 0 ? rows / seconds : 0, utilities::peak_rss()};
+}
+
+size_t number_of_lines(const coverage::ProjectCoverage &data) {
+    size_t rows = 0;
+    for (auto const &pkg : data.packages) {
+        for (auto const &afile : pkg.files) {
+            rows += afile.lines.size();
+        }
+    }
+    return rows;
+}
+
+template <typename OArchive, typename IArchive>
+void measure_archive(const std::string &name, const coverage::ProjectCoverage &data,
+                     std::vector<Measurement> &results) {
+    const size_t rows = number_of_lines(data);
+    std::stringstream buffer;
+    results.emplace_back(measure(name + "::encode", [&]() {
+        OArchive oar(buffer);
+        oar(cereal::make_nvp("coverage", data));
+        return rows;
+    }));
+    results.emplace_back(measure(name + "::decode", [&]() {
+        coverage::ProjectCoverage decoded;
+        IArchive iar(buffer);
+        iar(cereal::make_nvp("coverage", decoded));
+        return number_of_lines(decoded);
+    }));
+}
+
+// Measure the time and the peak memory of each ingestion phase and print the
+// results as JSON. Build with CLOVER_INSTRUMENTATION to also print the phase
+// statistics collected by the parsers and the database.
+//   profile <clover.xml> [junit.xml]
+int main(int argc, char *argv[]) {
+    if (argc < 2) return EXIT_SUCCESS;
+
+    const std::string clover_file(argv[1]);
+    std::vector<Measurement> results;
+    std::vector<instrumentation::Statistics> statistics;
+
+    coverage::ProjectCoverage data;
+    coverage::CloverParser clover_parser;
+    results.emplace_back(measure("CloverParser", [&]() {
+        data = clover_parser(clover_file);
+        return number_of_lines(data);
+    }));
+
+    results.emplace_back(measure("compute_file_metrics", [&]() {
+        size_t rows = 0;
+        for (auto const &pkg : data.packages) {
+            for (auto const &afile : pkg.files) {
+                rows += coverage::compute_file_metrics(afile).metrics.elements > 0;
+            }
+        }
+        return rows;
+    }));
+
+    measure_archive<cereal::JSONOutputArchive, cereal::JSONInputArchive>("JSON", data,
+                                                                         results);
+    measure_archive<cereal::XMLOutputArchive, cereal::XMLInputArchive>("XML", data, results);
+    measure_archive<cereal::BinaryOutputArchive, cereal::BinaryInputArchive>("Binary", data,
+                                                                             results);
+    measure_archive<cereal::PortableBinaryOutputArchive, cereal::PortableBinaryInputArchive>(
+        "PortableBinary", data, results);
+
+    clover::Database<size_t, unsigned int> db;
+    results.emplace_back(measure("Database::parse", [&]() {
+        db.parse(0, clover_file.c_str());
+        return db.size();
+    }));
+
+    statistics.emplace_back(clover_parser.statistics());
+    statistics.emplace_back(db.statistics());
+
+    if (argc > 2) {
+        const std::string junit_file(argv[2]);
+        tap::Parser tap_parser;
+        results.emplace_back(measure("tap::Parser", [&]() {
+            size_t rows = 0;
+            for (auto const &suite : tap_parser(junit_file)) {
+                rows += suite.testcases.size();
+            }
+            return rows;
+        }));
+        statistics.emplace_back(tap_parser.statistics());
+    }
+
+    utilities::print<cereal::JSONOutputArchive>(results, true);
+#ifdef CLOVER_INSTRUMENTATION
+    utilities::print<cereal::JSONOutputArchive>(statistics, true);
+#endif
+    return EXIT_SUCCESS;
+}
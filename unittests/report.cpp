@@ -0,0 +1,57 @@
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#include "fmt/format.h"
+
+#include "clover_parser.hpp"
+#include "report.hpp"
+#include "utilities.hpp"
+
+#include "driver.hpp"
+
+// Write an annotated source report of a clover XML file and print the number
+// of pages and the throughput. Sources are read from <source root><path>.
+//   report [-j threads] [-f html|json] <clover.xml> <output> [source root]
+int main(int argc, char *argv[]) {
+    report::Config cfg;
+    int first = 1;
+    while (first + 1 < argc && argv[first][0] == '-') {
+        const std::string option(argv[first]);
+        const std::string value(argv[first + 1]);
+        if (option == "-j") {
+            cfg.threads = std::strtoul(value.c_str(), nullptr, 10);
+        } else if (option == "-f" && (value == "html" || value == "json")) {
+            cfg.format = value == "html" ? report::Format::HTML : report::Format::JSON;
+        } else {
+            fmt::print(stderr, "Unknown option: {} {}\n", option, value);
+            return EXIT_FAILURE;
+        }
+        first += 2;
+    }
+    if (first + 1 >= argc) {
+        fmt::print("Usage: {} [-j threads] [-f html|json] <clover.xml> <output> "
+                   "[source root]\n",
+                   argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (first + 2 < argc) cfg.source_root = argv[first + 2];
+
+    coverage::CloverParser parser;
+    const auto project = parser(argv[first]);
+    size_t files = 0, lines = 0;
+    for (const auto &package : project.packages) {
+        files += package.files.size();
+        for (const auto &file : package.files) lines += file.lines.size();
+    }
+
+    report::Writer writer(cfg);
+    const double elapsed = driver::measure([&]() { writer(project, argv[first + 1]); });
+
+    fmt::print("Number of packages: {}\n", project.packages.size());
+    fmt::print("Number of files: {}\n", files);
+    fmt::print("Number of lines: {}\n", lines);
+    fmt::print("Report: {:.3f} seconds, {:.0f} files/s\n", elapsed, files / elapsed);
+    fmt::print("Peak memory: {} bytes\n", utilities::peak_rss());
+    return EXIT_SUCCESS;
+}
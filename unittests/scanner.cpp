@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+#include "fmt/format.h"
+#include "pugixml.hpp"
+
+#include "clover.hpp"
+#include "clover_parser.hpp"
+#include "clover_scanner.hpp"
+#include "utilities.hpp"
+
+#include "driver.hpp"
+
+using Database = clover::Database<size_t, unsigned int>;
+
+// Return true if two databases have the same tests, source files, lines, and
+// coverage items.
+bool is_same_database(const Database &first, const Database &second) {
+    const auto &lhs = first.get_data();
+    const auto &rhs = second.get_data();
+    return first.get_tests() == second.get_tests() &&
+           first.get_source_files() == second.get_source_files() &&
+           first.get_lines() == second.get_lines() && lhs.size() == rhs.size() &&
+           std::equal(lhs.cbegin(), lhs.cend(), rhs.cbegin(), [](auto const &a, auto const &b) {
+               return a == b && a.info.type == b.info.type && a.info.count == b.info.count &&
+                      a.info.truecount == b.info.truecount &&
+                      a.info.falsecount == b.info.falsecount;
+           });
+}
+
+// Cross validate the scanner backend against pugixml and print the throughput
+// of both backends.
+//   scanner <clover.xml>...
+int main(int argc, char *argv[]) {
+    if (argc < 2) return EXIT_SUCCESS;
+
+    int status = EXIT_SUCCESS;
+    for (auto idx = 1; idx < argc; ++idx) {
+        const std::string data_file(argv[idx]);
+        const std::string buffer = utilities::read_file(data_file);
+        const double megabytes = buffer.size() / 1e6;
+
+        coverage::ProjectCoverage expected, results;
+        const double parser_time = driver::measure([&]() {
+            coverage::CloverParser parser;
+            expected = parser(data_file);
+        });
+        const double scanner_time = driver::measure([&]() {
+            coverage::CloverScanner scanner;
+            results = scanner(buffer.data(), buffer.data() + buffer.size(), data_file);
+        });
+
+        Database parsed_db, scanned_db;
+        const double parse_time =
+            driver::measure([&]() { parsed_db.parse(0, data_file.c_str()); });
+        const double scan_time =
+            driver::measure([&]() { scanned_db.scan(0, data_file.c_str()); });
+
+        // A truncated file is rejected and nothing of it is imported.
+        Database empty_db;
+        const char *truncated = buffer.data() + buffer.size() * 3 / 4;
+        const bool is_rejected = !scanned_db.scan(1, buffer.data(), truncated) &&
+                                 !empty_db.scan(1, buffer.data(), truncated) &&
+                                 is_same_database(scanned_db, parsed_db) &&
+                                 is_same_database(empty_db, Database());
+
+        // An end tag which does not match its start tag, e.g. the end tag of
+        // the first file is </package>, is rejected by all backends.
+        std::string mismatched(buffer);
+        const size_t pos = mismatched.find("</file>");
+        bool is_mismatch_rejected = pos != std::string::npos;
+        if (is_mismatch_rejected) {
+            mismatched.replace(pos, 7, "</package>");
+            const char *first = mismatched.data(), *last = first + mismatched.size();
+            pugi::xml_document doc;
+            bool is_scanned = true;
+            try {
+                coverage::CloverScanner scanner;
+                scanner(first, last, data_file);
+            } catch (const std::runtime_error &) {
+                is_scanned = false;
+            }
+            is_mismatch_rejected = !doc.load_buffer(first, mismatched.size()) && !is_scanned &&
+                                   !empty_db.scan(1, first, last) &&
+                                   is_same_database(empty_db, Database());
+        }
+
+        const bool is_same = (expected == results) && is_same_database(parsed_db, scanned_db) &&
+                             is_rejected && is_mismatch_rejected;
+        if (!is_same) status = EXIT_FAILURE;
+        fmt::print("{}: {}\n", data_file, is_same ? "OK" : "MISMATCH");
+        fmt::print("  CloverParser: {:.3f} seconds, {:.1f} MB/s\n", parser_time,
+                   megabytes / parser_time);
+        fmt::print("  CloverScanner: {:.3f} seconds, {:.1f} MB/s\n", scanner_time,
+                   megabytes / scanner_time);
+        fmt::print("  Database::parse: {:.3f} seconds, {:.1f} MB/s\n", parse_time,
+                   megabytes / parse_time);
+        fmt::print("  Database::scan: {:.3f} seconds, {:.1f} MB/s\n", scan_time,
+                   megabytes / scan_time);
+    }
+
+    return status;
+}